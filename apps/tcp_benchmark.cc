@@ -1,10 +1,18 @@
+#include "congestion_controller.hh"
+#include "lossy_fd_adapter.hh"
 #include "tcp_connection.hh"
+#include "timing_wheel.hh"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <optional>
+#include <queue>
+#include <random>
 #include <string>
+#include <vector>
 
 using namespace std;
 using namespace std::chrono;
@@ -13,7 +21,15 @@ constexpr size_t len = 100 * 1024 * 1024;
 
 void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segments, const bool reorder) {
     while (not x.segments_out().empty()) {
-        segments.emplace_back(move(x.segments_out().front()));
+        auto &seg = x.segments_out().front();
+        if (seg.needs_split()) {
+            // what the adapter does with a super-segment
+            for (auto &piece : seg.split(seg.wire_mss())) {
+                segments.emplace_back(move(piece));
+            }
+        } else {
+            segments.emplace_back(move(seg));
+        }
         x.segments_out().pop();
     }
     if (reorder) {
@@ -28,8 +44,18 @@ void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segme
     segments.clear();
 }
 
-void main_loop(const bool reorder) {
+//! Share of the segments `x` and `y` received that took the header-prediction fast path
+static double predicted_percent(const TCPConnection &x, const TCPConnection &y) {
+    const auto fast = x.prediction_counters().fast_path + y.prediction_counters().fast_path;
+    const auto slow = x.prediction_counters().slow_path + y.prediction_counters().slow_path;
+    return fast + slow > 0 ? 100.0 * double(fast) / double(fast + slow) : 0;
+}
+
+void main_loop(const bool reorder, const bool tso = false) {
     TCPConfig config;
+    config.adaptive_rto = true;
+    config.tso_size = tso ? TCPConfig::MAX_TSO_SIZE : 0;
+    config.delayed_ack = true;
     TCPConnection x{config}, y{config};
 
     string string_to_send(len, 'x');
@@ -52,7 +78,7 @@ void main_loop(const bool reorder) {
         // write input into x
         while (bytes_to_send.size() and x.remaining_outbound_capacity()) {
             const auto want = min(x.remaining_outbound_capacity(), bytes_to_send.size());
-            const auto written = x.write(string(bytes_to_send.str().substr(0, want)));
+            const auto written = x.write(bytes_to_send.substr(0, want));
             if (want != written) {
                 throw runtime_error("want = " + to_string(want) + ", written = " + to_string(written));
             }
@@ -72,7 +98,9 @@ void main_loop(const bool reorder) {
         // read output from y
         const auto available_output = y.inbound_stream().buffer_size();
         if (available_output > 0) {
-            string_received.append(y.inbound_stream().read(available_output));
+            const auto received_so_far = string_received.size();
+            string_received.resize(received_so_far + available_output);
+            y.inbound_stream().read_into(string_received.data() + received_so_far, available_output);
         }
 
         // time passes
@@ -95,18 +123,349 @@ void main_loop(const bool reorder) {
     const auto gigabits_per_second = len * 8.0 / double(duration);
 
     cout << fixed << setprecision(2);
-    cout << "CPU-limited throughput" << (reorder ? " with reordering: " : "                : ") << gigabits_per_second
-         << " Gbit/s\n";
+    const auto label = reorder ? " with reordering: " : tso ? " with TSO       : " : "                : ";
+    cout << "CPU-limited throughput" << label << gigabits_per_second
+         << " Gbit/s (smoothed RTT " << x.rtt_estimator().srtt_ms().value_or(0) << " ms, RTO " << x.rto_ms()
+         << " ms, " << y.ack_counters().pure_acks_sent << " pure ACKs sent, " << y.ack_counters().pure_acks_suppressed
+         << " suppressed, " << predicted_percent(x, y) << "% of segments predicted)\n";
 
     while (x.active() or y.active()) {
         loop();
     }
 }
 
-int main() {
+//! \brief How long a congestion controller takes to refill a long, fat path after a single loss
+//! \details The path is simulated at the controller level: 1 Gbit/s with a 100 ms RTT, and every
+//! round trip the receiver acknowledges min(cwnd, BDP) bytes, one ACK per two segments.
+void recovery(const CongestionController::Algorithm algorithm, const string &name) {
+    constexpr size_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+    constexpr size_t bdp = 12'500'000;  // bytes
+    constexpr uint64_t rtt_ms = 100;
+    constexpr size_t ack_bytes = 2 * mss;
+
+    auto cc = CongestionController::make(algorithm, mss);
+    uint64_t now_ms = 0;
+    const auto round_trip = [&] {
+        const auto window = min(cc->cwnd(), bdp);
+        for (size_t acked = 0; acked < window; acked += ack_bytes) {
+            cc->on_ack({ack_bytes, window - acked, now_ms + rtt_ms * acked / window});
+        }
+        now_ms += rtt_ms;
+    };
+
+    while (cc->cwnd() < bdp) {
+        round_trip();
+    }
+    cc->on_loss(bdp, now_ms);
+
+    const auto loss_ms = now_ms;
+    unsigned round_trips = 0;
+    while (cc->cwnd() < bdp) {
+        round_trip();
+        ++round_trips;
+    }
+
+    cout << fixed << setprecision(1);
+    cout << "Recovery after one loss at 1 Gbit/s, 100 ms RTT (" << name << "): " << double(now_ms - loss_ms) / 1000
+         << " s (" << round_trips << " round trips)\n";
+}
+
+//! \brief Goodput of a transfer over a path that drops and reorders data segments at random
+//! \details Every loop iteration is one 10 ms round trip: x's segments (minus the dropped ones, and with
+//! some swapped with the next one) reach y, and y's ACKs all come back. Without fast retransmit,
+//! every loss costs at least a 200 ms RTO; without SACK, recovery repairs one hole per round trip.
+void lossy_transfer(const string &name, const TCPConfig &config, const double loss_rate, const double reorder_rate) {
+    constexpr size_t transfer_len = 8 * 1024 * 1024;
+    constexpr uint64_t rtt_ms = 10;
+
+    TCPConnection x{config}, y{config};
+    mt19937 rng{1};
+    bernoulli_distribution drop{loss_rate}, reorder{reorder_rate};
+
+    Buffer bytes_to_send{string(transfer_len, 'x')};
+    x.connect();
+    y.end_input_stream();
+
+    size_t received = 0;
+    const auto deliver = [&](const TCPSegment &seg) {
+        y.segment_received(seg);
+        // the application keeps up, so the advertised window stays open
+        received += y.inbound_stream().read_buffers(y.inbound_stream().buffer_size()).size();
+    };
+
+    uint64_t now_ms = 0;
+    const auto round_trip = [&] {
+        while (bytes_to_send.size() and x.remaining_outbound_capacity()) {
+            const auto written = x.write(bytes_to_send.substr(0, x.remaining_outbound_capacity()));
+            bytes_to_send.remove_prefix(written);
+            if (bytes_to_send.size() == 0) {
+                x.end_input_stream();
+            }
+        }
+
+        optional<TCPSegment> held;  // a segment that will arrive after the next one
+        while (not x.segments_out().empty()) {
+            auto seg = move(x.segments_out().front());
+            x.segments_out().pop();
+            if (seg.payload().size() > 0 and drop(rng)) {
+                continue;
+            }
+            if (seg.payload().size() > 0 and not held.has_value() and reorder(rng)) {
+                held = move(seg);
+                continue;
+            }
+            deliver(seg);
+            if (held.has_value()) {
+                deliver(held.value());
+                held.reset();
+            }
+        }
+        if (held.has_value()) {
+            deliver(held.value());
+        }
+        while (not y.segments_out().empty()) {
+            x.segment_received(y.segments_out().front());
+            y.segments_out().pop();
+        }
+
+        x.tick(rtt_ms);
+        y.tick(rtt_ms);
+        now_ms += rtt_ms;
+    };
+
+    while (not y.inbound_stream().eof()) {
+        round_trip();
+    }
+    const auto transfer_ms = now_ms;
+    while (x.active() or y.active()) {
+        round_trip();
+    }
+
+    if (received != transfer_len) {
+        throw runtime_error("received " + to_string(received) + " bytes, expected " + to_string(transfer_len));
+    }
+
+    cout << fixed << setprecision(1);
+    cout << "Goodput at " << loss_rate * 100 << "% loss";
+    if (reorder_rate > 0) {
+        cout << ", " << reorder_rate * 100 << "% reordering";
+    }
+    cout << ", 10 ms RTT (" << name << "): " << double(transfer_len) * 8 / 1000 / double(transfer_ms) << " Mbit/s\n";
+}
+
+//! \brief Compare loss recovery with and without fast retransmit and SACK
+//! \param baselines adds runs without loss (with 64 KB and 1 MiB buffers) and with neither mechanism
+void lossy_transfers(const double loss_rate, const double reorder_rate, const bool baselines) {
+    TCPConfig config;
+    config.adaptive_rto = true;
+    config.sack = false;
+    if (baselines) {
+        lossy_transfer("no loss", config, 0, 0);
+        TCPConfig scaled = config;  // window scaling lets the window outgrow 64 KiB
+        scaled.recv_capacity = scaled.send_capacity = 1024 * 1024;
+        lossy_transfer("no loss, 1 MiB buffers", scaled, 0, 0);
+        config.fast_retransmit = false;
+        lossy_transfer("RTO only", config, loss_rate, reorder_rate);
+        config.fast_retransmit = true;
+    }
+    lossy_transfer("fast retransmit", config, loss_rate, reorder_rate);
+    config.sack = true;
+    config.rack = false;
+    lossy_transfer("fast retransmit + SACK", config, loss_rate, reorder_rate);
+    config.rack = true;
+    lossy_transfer("fast retransmit + SACK + RACK-TLP", config, loss_rate, reorder_rate);
+}
+
+//! A datagram path that hands back what is written to it, in order, for LossyFdAdapter to drop from
+class LoopbackAdapter {
+  private:
+    FdAdapterConfig _cfg{};
+    queue<TCPSegment> _datagrams{};
+
+  public:
+    optional<TCPSegment> read() {
+        if (_datagrams.empty()) {
+            return {};
+        }
+        auto seg = move(_datagrams.front());
+        _datagrams.pop();
+        return seg;
+    }
+    void write(TCPSegment &seg) { _datagrams.push(seg); }
+    const FdAdapterConfig &config() const { return _cfg; }
+    FdAdapterConfig &config_mut() { return _cfg; }
+    void tick(const size_t) {}
+};
+
+//! \brief Completion times of short responses whose segments are dropped at random
+//! \details x answers 2000 requests on one connection with 10 segments each, over a 10 ms round trip; the
+//! path drops each of x's segments with probability `loss_rate`. A loss among the last three segments of
+//! a response brings too few duplicate ACKs for fast retransmit, so without a tail loss probe it waits
+//! for the RTO (at least 200 ms).
+void tail_loss(const string &name, const TCPConfig &config, const double loss_rate) {
+    constexpr size_t responses = 2000;
+    constexpr size_t response_len = 10 * TCPConfig::MAX_PAYLOAD_SIZE;
+    constexpr uint64_t rtt_ms = 10;
+
+    TCPConnection x{config}, y{config};
+    LossyFdAdapter<LoopbackAdapter> path{LoopbackAdapter{}};
+
+    uint64_t now_ms = 0;
+    size_t received = 0;
+    const auto round_trip = [&] {
+        while (not x.segments_out().empty()) {
+            path.write(x.segments_out().front());
+            x.segments_out().pop();
+        }
+        while (auto seg = path.read()) {
+            y.segment_received(seg.value());
+        }
+        received += y.inbound_stream().read_buffers(y.inbound_stream().buffer_size()).size();
+        while (not y.segments_out().empty()) {
+            x.segment_received(y.segments_out().front());
+            y.segments_out().pop();
+        }
+        x.tick(rtt_ms);
+        y.tick(rtt_ms);
+        now_ms += rtt_ms;
+    };
+
+    x.connect();
+    round_trip();
+    round_trip();
+    path.config_mut().loss_rate_up = static_cast<uint16_t>(loss_rate * 65536);  // the handshake is not dropped
+
+    vector<uint64_t> completion_ms;
+    for (size_t i = 0; i < responses; ++i) {
+        const auto start_ms = now_ms;
+        x.write(string(response_len, 'x'));
+        while (received < (i + 1) * response_len) {
+            round_trip();
+        }
+        completion_ms.push_back(now_ms - start_ms);
+    }
+    x.end_input_stream();
+    y.end_input_stream();
+    while (x.active() or y.active()) {
+        round_trip();
+    }
+    sort(completion_ms.begin(), completion_ms.end());
+    uint64_t total_ms = 0;
+    for (const auto ms : completion_ms) {
+        total_ms += ms;
+    }
+
+    cout << fixed << setprecision(1);
+    cout << "Response time at " << loss_rate * 100 << "% loss, 10 ms RTT (" << name
+         << "): mean " << double(total_ms) / responses << " ms, 99th percentile "
+         << completion_ms[responses * 99 / 100] << " ms\n";
+}
+
+//! \brief Compare tail-loss recovery with and without RACK-TLP
+void tail_losses(const double loss_rate) {
+    TCPConfig config;
+    config.adaptive_rto = true;
+    tail_loss("no loss", config, 0);
+    config.rack = false;
+    tail_loss("SACK", config, loss_rate);
+    config.rack = true;
+    tail_loss("SACK + RACK-TLP", config, loss_rate);
+}
+
+//! \brief Cost of keeping time for many connections: ticking each one every 10 ms, or keeping their timers
+//! on a shared TimingWheel, which calls only those whose timers come due
+//! \details Every connection sends a SYN that is never answered, and retransmits it (with a 10 ms initial
+//! RTO, doubling) until it gives up, 10.2 s later; the run lasts 12 s.
+void timer_scaling(const size_t connections) {
+    constexpr uint64_t tick_ms = 10;
+    constexpr uint64_t run_ms = 12'000;
+    TCPConfig config;
+    config.rt_timeout = 10;
+    config.send_capacity = config.recv_capacity = 1024;
+
+    // with a wheel, connection `i` files its timers on it under endpoint `i`
+    const auto run = [&](const string &name, TimingWheel *wheel, auto &&drive) {
+        vector<TCPConnection> conns;
+        conns.reserve(connections);
+        for (size_t i = 0; i < connections; ++i) {
+            if (wheel != nullptr) {
+                conns.emplace_back(config, *wheel, i);
+            } else {
+                conns.emplace_back(config);
+            }
+            conns.back().connect();
+        }
+        size_t segments = 0;
+        const auto drain = [&](TCPConnection &conn) {
+            for (; not conn.segments_out().empty(); conn.segments_out().pop()) {
+                ++segments;
+            }
+        };
+
+        const auto first_time = high_resolution_clock::now();
+        drive(conns, drain);
+        const auto duration = duration_cast<nanoseconds>(high_resolution_clock::now() - first_time).count();
+
+        cout << fixed << setprecision(2);
+        cout << "Keeping time for " << connections << " connections (" << name << "): "
+             << double(duration) / double(run_ms / tick_ms) / 1000 << " us per " << tick_ms << " ms tick ("
+             << segments << " segments sent)\n";
+    };
+
+    run("tick each", nullptr, [&](vector<TCPConnection> &conns, auto &&drain) {
+        for (uint64_t now_ms = 0; now_ms < run_ms; now_ms += tick_ms) {
+            for (auto &conn : conns) {
+                if (conn.active()) {
+                    conn.tick(tick_ms);
+                    drain(conn);
+                }
+            }
+        }
+    });
+
+    TimingWheel wheel;
+    run("timing wheel", &wheel, [&](vector<TCPConnection> &conns, auto &&drain) {
+        for (uint64_t now_ms = 0; now_ms < run_ms; now_ms += tick_ms) {
+            wheel.advance(tick_ms, [&](const uint64_t key) {
+                auto &conn = conns[TCPTimers::endpoint_of(key)];
+                conn.timer_expired(TCPTimers::kind_of(key));
+                drain(conn);
+            });
+        }
+    });
+}
+
+int main(int argc, char *argv[]) {
     try {
+        if (argc == 2 and argv[1] == string("recovery")) {
+            recovery(CongestionController::Algorithm::NewReno, "NewReno");
+            recovery(CongestionController::Algorithm::Cubic, "CUBIC");
+            return EXIT_SUCCESS;
+        }
+        if (argc == 2 and argv[1] == string("loss")) {
+            lossy_transfers(0.01, 0, true);
+            return EXIT_SUCCESS;
+        }
+        if (argc == 2 and argv[1] == string("reorder")) {
+            lossy_transfers(0.02, 0.05, false);
+            return EXIT_SUCCESS;
+        }
+        if (argc == 2 and argv[1] == string("tail")) {
+            tail_losses(0.03);
+            return EXIT_SUCCESS;
+        }
+        if (argc == 2 and argv[1] == string("timers")) {
+            timer_scaling(50'000);
+            return EXIT_SUCCESS;
+        }
+        if (argc != 1) {
+            cerr << "Usage: " << argv[0] << " [recovery|loss|reorder|tail|timers]\n";
+            return EXIT_FAILURE;
+        }
+
         main_loop(false);
         main_loop(true);
+        main_loop(false, true);
     } catch (const exception &e) {
         cerr << e.what() << "\n";
         return EXIT_FAILURE;
@@ -21,6 +21,23 @@ add_test(NAME t_send_window          COMMAND send_window)
 add_test(NAME t_send_ack             COMMAND send_ack)
 add_test(NAME t_send_close           COMMAND send_close)
 add_test(NAME t_send_extra           COMMAND send_extra)
+add_test(NAME t_send_zero_copy       COMMAND send_zero_copy)
+add_test(NAME t_send_congestion      COMMAND send_congestion)
+add_test(NAME t_send_rtt             COMMAND send_rtt)
+add_test(NAME t_send_fast_retx       COMMAND send_fast_retransmit)
+add_test(NAME t_send_pacing         COMMAND send_pacing)
+add_test(NAME t_send_nagle          COMMAND send_nagle)
+add_test(NAME t_retx_queue          COMMAND retransmission_queue)
+add_test(NAME t_timing_wheel        COMMAND timing_wheel)
+add_test(NAME t_tcp_tso             COMMAND tcp_tso)
+add_test(NAME t_tcp_delayed_ack     COMMAND tcp_delayed_ack)
+add_test(NAME t_tcp_window_scale    COMMAND tcp_window_scale)
+add_test(NAME t_tcp_timestamps      COMMAND tcp_timestamps)
+add_test(NAME t_tcp_mss             COMMAND tcp_mss)
+add_test(NAME t_tcp_rack            COMMAND tcp_rack)
+add_test(NAME t_tcp_ecn             COMMAND tcp_ecn)
+add_test(NAME t_tcp_header_prediction COMMAND tcp_header_prediction)
+add_test(NAME t_tcp_sack            COMMAND tcp_sack)
 
 add_test(NAME t_strm_reassem_single      COMMAND fsm_stream_reassembler_single)
 add_test(NAME t_strm_reassem_seq         COMMAND fsm_stream_reassembler_seq)
@@ -30,12 +47,14 @@ add_test(NAME t_strm_reassem_many        COMMAND fsm_stream_reassembler_many)
 add_test(NAME t_strm_reassem_overlapping COMMAND fsm_stream_reassembler_overlapping)
 add_test(NAME t_strm_reassem_win         COMMAND fsm_stream_reassembler_win)
 add_test(NAME t_strm_reassem_cap         COMMAND fsm_stream_reassembler_cap)
+add_test(NAME t_strm_reassem_engines     COMMAND fsm_stream_reassembler_engines)
 
 add_test(NAME t_byte_stream_construction COMMAND byte_stream_construction)
 add_test(NAME t_byte_stream_one_write    COMMAND byte_stream_one_write)
 add_test(NAME t_byte_stream_two_writes   COMMAND byte_stream_two_writes)
 add_test(NAME t_byte_stream_capacity     COMMAND byte_stream_capacity)
 add_test(NAME t_byte_stream_many_writes  COMMAND byte_stream_many_writes)
+add_test(NAME t_byte_stream_spans       COMMAND byte_stream_spans)
 
 add_test(NAME t_webget               COMMAND "${PROJECT_SOURCE_DIR}/tests/webget_t.sh")
 
@@ -0,0 +1,151 @@
+#include "bbr_controller.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+BBRController::BBRController(const size_t mss) : _mss(mss), _cwnd(NewRenoController::INITIAL_WINDOW * mss) {}
+
+size_t BBRController::bdp() const {
+    if (not _min_rtt_ms.has_value()) {
+        return 0;
+    }
+    return btl_bw() * max<uint64_t>(_min_rtt_ms.value(), 1) / 1000;  // the clock only has millisecond resolution
+}
+
+//! \details Until the pipe is full the rate is at least the window per min_rtt, as Linux does:
+//! early samples (the SYN's ACK delivers one byte) badly underestimate the bandwidth.
+uint64_t BBRController::pacing_rate() const {
+    auto rate = _pacing_gain * static_cast<double>(btl_bw());
+    if (not _filled_pipe and _min_rtt_ms.has_value()) {
+        const auto min_rtt = static_cast<double>(max<uint64_t>(_min_rtt_ms.value(), 1));
+        rate = max(rate, HIGH_GAIN * static_cast<double>(_cwnd) * 1000 / min_rtt);
+    }
+    return static_cast<uint64_t>(rate);
+}
+
+void BBRController::on_ack(const AckSample &sample) {
+    const bool min_rtt_expired =
+        _min_rtt_ms.has_value() and sample.now_ms > _min_rtt_stamp_ms + MIN_RTT_WINDOW_MS;
+    _update_model(sample);
+
+    // a fresh sample replaces the minimum once it has expired, even if it is larger
+    if (sample.rtt_ms.has_value() and
+        (not _min_rtt_ms.has_value() or sample.rtt_ms.value() <= _min_rtt_ms.value() or min_rtt_expired)) {
+        _min_rtt_ms = sample.rtt_ms;
+        _min_rtt_stamp_ms = sample.now_ms;
+    }
+
+    _update_state(sample, min_rtt_expired);
+    _update_cwnd(sample);
+}
+
+void BBRController::on_rto(const size_t, const uint64_t) { _cwnd = _mss; }
+
+void BBRController::_update_model(const AckSample &sample) {
+    _round_start = false;
+    if (sample.delivered > 0 and sample.prior_delivered >= _next_round_delivered) {
+        _next_round_delivered = sample.delivered;
+        ++_round_count;
+        _round_start = true;
+    }
+
+    // application-limited samples underestimate the bandwidth, unless they exceed the estimate anyway
+    if (sample.delivery_rate > 0 and (not sample.app_limited or sample.delivery_rate >= btl_bw())) {
+        while (not _bw_filter.empty() and _bw_filter.back().second <= sample.delivery_rate) {
+            _bw_filter.pop_back();
+        }
+        _bw_filter.emplace_back(_round_count, sample.delivery_rate);
+    }
+    while (not _bw_filter.empty() and _bw_filter.front().first + BW_WINDOW_ROUNDS <= _round_count) {
+        _bw_filter.pop_front();
+    }
+}
+
+void BBRController::_update_state(const AckSample &sample, const bool min_rtt_expired) {
+    if (_round_start and not _filled_pipe and not sample.app_limited) {
+        if (btl_bw() >= _full_bw + _full_bw / 4) {
+            _full_bw = btl_bw();
+            _full_bw_count = 0;
+        } else if (++_full_bw_count >= 3) {
+            _filled_pipe = true;
+        }
+    }
+
+    if (_state == State::Startup and _filled_pipe) {
+        _set_state(State::Drain, 1 / HIGH_GAIN, HIGH_GAIN);
+    }
+    if (_state == State::Drain and sample.bytes_in_flight <= bdp()) {
+        _enter_probe_bw(sample.now_ms);
+    }
+
+    if (_state == State::ProbeBW) {
+        // each phase lasts one min_rtt, except that the draining phase ends once the queue is gone
+        const bool elapsed = sample.now_ms - _cycle_stamp_ms > _min_rtt_ms.value_or(0);
+        if (elapsed or (_pacing_gain < 1 and sample.bytes_in_flight <= bdp())) {
+            _cycle_index = (_cycle_index + 1) % PACING_GAIN_CYCLE.size();
+            _cycle_stamp_ms = sample.now_ms;
+            _pacing_gain = PACING_GAIN_CYCLE.at(_cycle_index);
+        }
+    }
+
+    if (_state != State::ProbeRTT and min_rtt_expired) {
+        _prior_cwnd = _cwnd;
+        _set_state(State::ProbeRTT, 1, 1);
+        _probe_rtt_done_ms.reset();
+    }
+
+    if (_state == State::ProbeRTT) {
+        if (not _probe_rtt_done_ms.has_value()) {
+            // wait for the window to drain to the minimum, then hold it there for PROBE_RTT_MS and a round
+            if (sample.bytes_in_flight <= MIN_CWND_SEGMENTS * _mss) {
+                _probe_rtt_done_ms = sample.now_ms + PROBE_RTT_MS;
+                _probe_rtt_round_done = false;
+                _next_round_delivered = sample.delivered;
+            }
+        } else {
+            _probe_rtt_round_done = _probe_rtt_round_done or _round_start;
+            if (_probe_rtt_round_done and sample.now_ms >= _probe_rtt_done_ms.value()) {
+                _min_rtt_stamp_ms = sample.now_ms;
+                _cwnd = max(_cwnd, _prior_cwnd);
+                if (_filled_pipe) {
+                    _enter_probe_bw(sample.now_ms);
+                } else {
+                    _set_state(State::Startup, HIGH_GAIN, HIGH_GAIN);
+                }
+            }
+        }
+    }
+}
+
+//! \details The target is `cwnd_gain` BDPs plus a few segments for delayed and stretched ACKs.
+//! Until the pipe is full the window only grows; afterwards it moves toward the target.
+void BBRController::_update_cwnd(const AckSample &sample) {
+    const auto min_cwnd = MIN_CWND_SEGMENTS * _mss;
+    if (_state == State::ProbeRTT) {
+        _cwnd = min_cwnd;
+        return;
+    }
+
+    const auto target = static_cast<size_t>(_cwnd_gain * static_cast<double>(bdp())) + 3 * _mss;
+    if (_filled_pipe) {
+        _cwnd = min(_cwnd + sample.acked_bytes, target);
+    } else if (bdp() == 0 or _cwnd < target or sample.delivered < NewRenoController::INITIAL_WINDOW * _mss) {
+        _cwnd += sample.acked_bytes;
+    }
+    _cwnd = max(_cwnd, min_cwnd);
+}
+
+//! \details Starts in a cruising phase rather than probing right after DRAIN
+void BBRController::_enter_probe_bw(const uint64_t now_ms) {
+    _set_state(State::ProbeBW, 1, 2);
+    _cycle_index = 2;
+    _cycle_stamp_ms = now_ms;
+    _pacing_gain = PACING_GAIN_CYCLE.at(_cycle_index);
+}
+
+void BBRController::_set_state(const State state, const double pacing_gain, const double cwnd_gain) {
+    _state = state;
+    _pacing_gain = pacing_gain;
+    _cwnd_gain = cwnd_gain;
+}
@@ -0,0 +1,95 @@
+#ifndef SPONGE_LIBSPONGE_BBR_CONTROLLER_HH
+#define SPONGE_LIBSPONGE_BBR_CONTROLLER_HH
+
+#include "congestion_controller.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <utility>
+
+//! \brief A BBR-style model-based congestion controller (after BBR v1, draft-cardwell-iccrg-bbr-congestion-control)
+//!
+//! Instead of reacting to loss, BBR estimates the bottleneck bandwidth (windowed max of the
+//! delivery-rate samples) and the minimum RTT (windowed min of the RTT samples), paces at
+//! `pacing_gain` times the bandwidth and keeps about `cwnd_gain` bandwidth-delay products in
+//! flight. STARTUP doubles the rate every round until the bandwidth stops growing, DRAIN
+//! empties the queue STARTUP built, PROBE_BW cycles the pacing gain to probe for more
+//! bandwidth, and PROBE_RTT briefly shrinks the window to re-measure the minimum RTT.
+class BBRController : public CongestionController {
+  public:
+    //! The phases of the model
+    enum class State { Startup, Drain, ProbeBW, ProbeRTT };
+
+    static constexpr double HIGH_GAIN = 2.885;             //!< 2/ln(2): doubles the rate every round
+    static constexpr unsigned BW_WINDOW_ROUNDS = 10;       //!< Rounds covered by the bandwidth max filter
+    static constexpr uint64_t MIN_RTT_WINDOW_MS = 10'000;  //!< Lifetime of a min-RTT sample
+    static constexpr uint64_t PROBE_RTT_MS = 200;          //!< Time spent at the minimum window in PROBE_RTT
+    static constexpr size_t MIN_CWND_SEGMENTS = 4;         //!< Smallest window, in segments
+    static constexpr std::array<double, 8> PACING_GAIN_CYCLE{1.25, 0.75, 1, 1, 1, 1, 1, 1};  //!< PROBE_BW gains
+
+  private:
+    size_t _mss;
+    State _state = State::Startup;
+    size_t _cwnd;
+    size_t _prior_cwnd = 0;  //!< cwnd before PROBE_RTT, restored afterwards
+    double _pacing_gain = HIGH_GAIN;
+    double _cwnd_gain = HIGH_GAIN;
+
+    //! \name Round counting: a round ends when a segment sent after its start is acknowledged
+    //!@{
+    uint64_t _round_count = 0;
+    uint64_t _next_round_delivered = 0;
+    bool _round_start = false;
+    //!@}
+
+    //! (round, rate) samples in decreasing rate order: a sliding-window max filter
+    std::deque<std::pair<uint64_t, uint64_t>> _bw_filter{};
+
+    std::optional<uint64_t> _min_rtt_ms{};
+    uint64_t _min_rtt_stamp_ms = 0;  //!< When _min_rtt_ms was measured
+
+    //! \name STARTUP exit: the pipe is full once the bandwidth grows less than 25% in three rounds
+    //!@{
+    bool _filled_pipe = false;
+    uint64_t _full_bw = 0;
+    unsigned _full_bw_count = 0;
+    //!@}
+
+    size_t _cycle_index = 0;      //!< Position in PACING_GAIN_CYCLE
+    uint64_t _cycle_stamp_ms = 0;  //!< When the current gain phase started
+
+    std::optional<uint64_t> _probe_rtt_done_ms{};  //!< When PROBE_RTT may end, once at the minimum window
+    bool _probe_rtt_round_done = false;
+
+    void _update_model(const AckSample &sample);
+    void _update_state(const AckSample &sample, const bool min_rtt_expired);
+    void _update_cwnd(const AckSample &sample);
+    void _enter_probe_bw(const uint64_t now_ms);
+    void _set_state(const State state, const double pacing_gain, const double cwnd_gain);
+
+  public:
+    explicit BBRController(const size_t mss);
+
+    size_t cwnd() const override { return _cwnd; }
+    uint64_t pacing_rate() const override;
+    void on_ack(const AckSample &sample) override;
+
+    //! Loss is not a congestion signal for the model
+    void on_loss(const size_t, const uint64_t) override {}
+
+    //! Fall back to one segment in flight until ACKs resume
+    void on_rto(const size_t bytes_in_flight, const uint64_t now_ms) override;
+
+    //! \name The model
+    //!@{
+    State state() const { return _state; }
+    uint64_t btl_bw() const { return _bw_filter.empty() ? 0 : _bw_filter.front().second; }  //!< Bytes per second
+    std::optional<uint64_t> min_rtt_ms() const { return _min_rtt_ms; }
+    size_t bdp() const;  //!< Estimated bandwidth-delay product, in bytes (0 until both estimates exist)
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_BBR_CONTROLLER_HH
@@ -1,5 +1,7 @@
 #include "byte_stream.hh"
 
+#include <cstring>
+
 // Dummy implementation of a flow-controlled in-memory byte stream.
 
 // For Lab 0, please replace with a real implementation that passes the
@@ -12,36 +14,132 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-ByteStream::ByteStream(const size_t capacity) : _buffer(capacity + 1), _capacity(capacity), _bytes_written(0),
-                                                _bytes_read(0), _head(0), _tail(_capacity) {}
- 
-size_t ByteStream::write(const string &data) {
-    auto n = min(data.size(), remaining_capacity());
-    for (size_t i = 0; i < n; ++i) {
-        _tail = (_tail + 1) % (_capacity + 1); // increase the buffer size by shifting the tail
-        _buffer[_tail] = data[i];
+ByteStream::ByteStream(const size_t capacity, const bool double_mapped)
+    : _buffer(capacity, double_mapped), _capacity(capacity), _bytes_written(0), _bytes_read(0), _head(0) {}
+
+size_t ByteStream::write(string_view data) {
+    const auto n = min(data.size(), remaining_capacity());
+    if (n == 0) {
+        return 0;
+    }
+    const auto tail = (_head + _ring_size) % _capacity;  // first free slot of the circular buffer
+    // bytes that fit before the wrap point (a double-mapped ring has no wrap point)
+    const auto first = _buffer.double_mapped() ? n : min(n, _capacity - tail);
+    memcpy(_buffer.data() + tail, data.data(), first);
+    memcpy(_buffer.data(), data.data() + first, n - first);
+
+    // consecutive copied writes share one chunk
+    if (_chunks.empty() or _chunks.back().ring_bytes == 0) {
+        _chunks.push_back({Buffer{}, n});
+    } else {
+        _chunks.back().ring_bytes += n;
     }
+    _ring_size += n;
     _bytes_written += n;
     return n;
 }
- 
+
+size_t ByteStream::write(Buffer data) {
+    const auto n = min(data.size(), remaining_capacity());
+    if (n == 0) {
+        return 0;
+    }
+    data.remove_suffix(data.size() - n);
+    // a small slice of a large Buffer (a header's worth of a datagram, say) would pin all of it
+    if (n * MAX_PIN_RATIO < data.storage_size()) {
+        return write(data.str());
+    }
+    _chunks.push_back({move(data), 0});
+    _bytes_written += n;
+    return n;
+}
+
+size_t ByteStream::write(const BufferList &data) {
+    size_t n = 0;
+    for (const auto &buffer : data.buffers()) {
+        const auto accepted = write(buffer);
+        n += accepted;
+        if (accepted < buffer.size()) {
+            break;
+        }
+    }
+    return n;
+}
+
+template <typename F>
+void ByteStream::_for_each_span(const size_t len, F &&f) const {
+    auto remaining = min(len, buffer_size());
+    auto ring_pos = _head;
+    for (auto it = _chunks.begin(); remaining > 0; ++it) {
+        if (it->ring_bytes == 0) {
+            const auto view = it->buffer.str().substr(0, remaining);
+            if (not f(view)) {
+                return;
+            }
+            remaining -= view.size();
+            continue;
+        }
+        const auto n = min(remaining, it->ring_bytes);
+        const auto first = _buffer.double_mapped() ? n : min(n, _capacity - ring_pos);  // bytes before the wrap point
+        if (not f(string_view{_buffer.data() + ring_pos, first})) {
+            return;
+        }
+        if (n > first and not f(string_view{_buffer.data(), n - first})) {
+            return;
+        }
+        ring_pos = (ring_pos + n) % _capacity;
+        remaining -= n;
+    }
+}
+
 //! \param[in] len bytes will be copied from the output side of the buffer
 string ByteStream::peek_output(const size_t len) const {
     string output;
-    auto n = min(len, buffer_size());
-    for (size_t i = 0; i < n; ++i) {
-        output.push_back(_buffer[(_head + i) % (_capacity + 1)]);
-    }
+    output.reserve(min(len, buffer_size()));
+    _for_each_span(len, [&](string_view span) {
+        output.append(span);
+        return true;
+    });
     return output;
 }
- 
+
+//! \param[in] len bytes will be exposed from the output side of the buffer
+array<string_view, 2> ByteStream::peek_spans(const size_t len) const {
+    array<string_view, 2> spans{};
+    size_t count = 0;
+    _for_each_span(len, [&](string_view span) {
+        spans[count++] = span;
+        return count < spans.size();
+    });
+    return spans;
+}
+
 //! \param[in] len bytes will be removed from the output side of the buffer
 void ByteStream::pop_output(const size_t len) {
     auto n = min(len, buffer_size());
-    _head = (_head + n) % (_capacity + 1); // fake pop in circular buffer
     _bytes_read += n;
+    while (n > 0) {
+        auto &front = _chunks.front();
+        if (front.ring_bytes == 0) {
+            const auto take = min(n, front.buffer.size());
+            front.buffer.remove_prefix(take);
+            n -= take;
+            if (front.buffer.size() == 0) {
+                _chunks.pop_front();
+            }
+            continue;
+        }
+        const auto take = min(n, front.ring_bytes);
+        _head = (_head + take) % _capacity;  // fake pop in circular buffer
+        _ring_size -= take;
+        front.ring_bytes -= take;
+        n -= take;
+        if (front.ring_bytes == 0) {
+            _chunks.pop_front();
+        }
+    }
 }
- 
+
 //! Read (i.e., copy and then pop) the next "len" bytes of the stream
 //! \param[in] len bytes will be popped and returned
 //! \returns a string
@@ -50,14 +148,40 @@ string ByteStream::read(const size_t len) {
     pop_output(len);
     return str_read;
 }
+
+//! \param[out] dst the destination, with room for at least `len` bytes
+//! \param[in] len the maximum number of bytes to copy and pop
+size_t ByteStream::read_into(char *dst, const size_t len) {
+    size_t n = 0;
+    _for_each_span(len, [&](string_view span) {
+        memcpy(dst + n, span.data(), span.size());
+        n += span.size();
+        return true;
+    });
+    pop_output(n);
+    return n;
+}
+
+//! \param[in] len bytes will be popped and returned
+//! \details Copied bytes are gathered into one new Buffer per run; Buffer chunks are sliced.
+BufferList ByteStream::read_buffers(const size_t len) {
+    BufferList ret;
+    auto remaining = min(len, buffer_size());
+    while (remaining > 0) {
+        const auto &front = _chunks.front();
+        const auto n = min(remaining, front.ring_bytes ? front.ring_bytes : front.buffer.size());
+        ret.append(front.ring_bytes ? Buffer{peek_output(n)} : front.buffer.substr(0, n));
+        pop_output(n);
+        remaining -= n;
+    }
+    return ret;
+}
  
 void ByteStream::end_input() { _closed = true; }
  
 bool ByteStream::input_ended() const { return _closed; }
  
-size_t ByteStream::buffer_size() const {
-     return (_tail - _head + 1 + _capacity + 1) % (_capacity + 1) ; // the size of the buffer; handles the wrap-around case 
-}
+size_t ByteStream::buffer_size() const { return _bytes_written - _bytes_read; }
  
 bool ByteStream::buffer_empty() const { return buffer_size() == 0; }
  
@@ -1,8 +1,13 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
+#include "buffer.hh"
+#include "ring_storage.hh"
+
+#include <array>
+#include <deque>
 #include <string>
-#include <vector>
+#include <string_view>
 
 //! \brief An in-order byte stream.
 
@@ -17,18 +22,36 @@ class ByteStream {
     // all, but if any of your tests are taking longer than a second,
     // that's a sign that you probably want to keep exploring
     // different approaches.
-    std::vector<char> _buffer;  // uses a (circular) vector to hold all the bytes, with length of capacity + 1
-    size_t _capacity;        
-    size_t _bytes_written; 
-    size_t _bytes_read;   
-    int _head, _tail;   // defines the valid range of the buffer
-    bool _closed {};  
+    //! A run of buffered bytes: either a refcounted Buffer slice or `ring_bytes` bytes copied into `_buffer`
+    struct Chunk {
+        Buffer buffer{};
+        size_t ring_bytes{};  //!< Nonzero iff the bytes live in the ring
+    };
+
+    RingStorage _buffer;  // circular storage holding the copied bytes, with length of capacity
+    std::deque<Chunk> _chunks{};  // all buffered bytes, in stream order
+    size_t _capacity;
+    size_t _bytes_written;
+    size_t _bytes_read;
+    size_t _head;  // index of the first unread byte in the ring
+    size_t _ring_size{};  // bytes held in the ring; the buffered size is _bytes_written - _bytes_read
+    bool _closed {};
 
     bool _error {};  //!< Flag indicating that the stream suffered an error.
 
+    //! Call `f` with each contiguous piece of the next min(len, buffer_size()) bytes, in order,
+    //! until it returns `false`
+    template <typename F>
+    void _for_each_span(const size_t len, F &&f) const;
+
   public:
+    //! A Buffer slice is kept only if its storage is at most this many times its size
+    static constexpr size_t MAX_PIN_RATIO = 4;
+
     //! Construct a stream with room for `capacity` bytes.
-    ByteStream(const size_t capacity);
+    //! \param double_mapped requests magic-ring storage (see RingStorage), so that reads and
+    //! writes never wrap; ignored unless `capacity` is page-aligned
+    ByteStream(const size_t capacity, const bool double_mapped = false);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -36,7 +59,23 @@ class ByteStream {
     //! Write a string of bytes into the stream. Write as many
     //! as will fit, and return how many were written.
     //! \returns the number of bytes accepted into the stream
-    size_t write(const std::string &data);
+    size_t write(const std::string &data) { return write(std::string_view(data)); }
+
+    //! Write a view of bytes into the stream without building a temporary string.
+    //! Copies at most twice (once on each side of the wrap point).
+    //! \returns the number of bytes accepted into the stream
+    size_t write(std::string_view data);
+
+    //! Append (a prefix of) a refcounted Buffer to the stream without copying its bytes.
+    //! The stream keeps a slice of `data`, which pins its storage until the bytes are popped.
+    //! A slice less than 1/MAX_PIN_RATIO of its storage is copied instead, so the storage the stream
+    //! pins stays within MAX_PIN_RATIO times the bytes it was given as Buffers (and so O(capacity)).
+    //! \returns the number of bytes accepted into the stream
+    size_t write(Buffer data);
+
+    //! Append (a prefix of) a BufferList to the stream without copying its bytes (see write(Buffer))
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const BufferList &data);
 
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
@@ -55,6 +94,14 @@ class ByteStream {
     //! \returns a string
     std::string peek_output(const size_t len) const;
 
+    //! Peek at next "len" bytes of the stream without copying them
+    //! \returns two views whose concatenation starts the next min(len, buffer_size()) bytes.
+    //! For copied bytes, the second view is empty unless they wrap around the end of the buffer
+    //! (which never happens with double-mapped storage). Bytes written as a Buffer get views
+    //! of their own, so the two views may stop short of `len`.
+    //! \note the views are invalidated by the next write or pop
+    std::array<std::string_view, 2> peek_spans(const size_t len) const;
+
     //! Remove bytes from the buffer
     void pop_output(const size_t len);
 
@@ -62,6 +109,15 @@ class ByteStream {
     //! \returns a string
     std::string read(const size_t len);
 
+    //! Read (i.e., copy and then pop) up to "len" bytes of the stream into `dst`
+    //! \returns the number of bytes copied
+    size_t read_into(char *dst, const size_t len);
+
+    //! Read (i.e., pop) the next "len" bytes of the stream as refcounted Buffers.
+    //! Bytes that were written as a Buffer are returned as slices of it, without a copy.
+    //! \returns a BufferList of min(len, buffer_size()) bytes
+    BufferList read_buffers(const size_t len);
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const;
 
@@ -0,0 +1,67 @@
+#include "congestion_controller.hh"
+
+#include "bbr_controller.hh"
+#include "cubic_controller.hh"
+#include "dctcp_controller.hh"
+
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+unique_ptr<CongestionController> CongestionController::make(const Algorithm algorithm, const size_t mss) {
+    switch (algorithm) {
+        case Algorithm::None:
+            return make_unique<UnlimitedController>();
+        case Algorithm::NewReno:
+            return make_unique<NewRenoController>(mss);
+        case Algorithm::Cubic:
+            return make_unique<CubicController>(mss);
+        case Algorithm::BBR:
+            return make_unique<BBRController>(mss);
+        case Algorithm::DCTCP:
+            return make_unique<DCTCPController>(mss);
+    }
+    return make_unique<NewRenoController>(mss);
+}
+
+size_t UnlimitedController::cwnd() const { return numeric_limits<size_t>::max(); }
+
+NewRenoController::NewRenoController(const size_t mss)
+    : _mss(mss), _cwnd(INITIAL_WINDOW * mss), _ssthresh(numeric_limits<size_t>::max()) {}
+
+//! \details In slow start the window grows by the bytes acknowledged (doubling every RTT);
+//! in congestion avoidance it grows by one MSS per window's worth of acknowledged bytes.
+void NewRenoController::on_ack(const AckSample &sample) {
+    if (sample.in_recovery) {
+        return;
+    }
+    auto acked = sample.acked_bytes;
+    if (_cwnd < _ssthresh) {
+        const auto growth = min(acked, _ssthresh - _cwnd);
+        _cwnd += growth;
+        acked -= growth;  // whatever is left over counts toward congestion avoidance
+    }
+
+    _acked_in_avoidance += acked;
+    while (_acked_in_avoidance >= _cwnd) {
+        _acked_in_avoidance -= _cwnd;
+        _cwnd += _mss;
+    }
+}
+
+void NewRenoController::_reduce_to(const size_t cwnd) {
+    _ssthresh = max(cwnd, 2 * _mss);
+    _cwnd = _ssthresh;
+    _acked_in_avoidance = 0;
+}
+
+//! \details Halve the window (RFC 5681, eq. 4) and continue in congestion avoidance
+void NewRenoController::on_loss(const size_t bytes_in_flight, const uint64_t) { _reduce_to(bytes_in_flight / 2); }
+
+//! \details Halve the threshold and restart from one segment in slow start
+void NewRenoController::on_rto(const size_t bytes_in_flight, const uint64_t) {
+    _ssthresh = max(bytes_in_flight / 2, 2 * _mss);
+    _cwnd = _mss;
+    _acked_in_avoidance = 0;
+}
@@ -0,0 +1,108 @@
+#ifndef SPONGE_LIBSPONGE_CONGESTION_CONTROLLER_HH
+#define SPONGE_LIBSPONGE_CONGESTION_CONTROLLER_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+//! \brief What the TCPSender tells its congestion controller about an acknowledgment
+struct AckSample {
+    size_t acked_bytes = 0;      //!< Sequence space newly acknowledged by this ACK
+    size_t bytes_in_flight = 0;  //!< Sequence space still outstanding after this ACK
+    uint64_t now_ms = 0;         //!< The sender's clock (total time passed to TCPSender::tick)
+
+    //! \name Delivery-rate sample, from the most recently sent of the acknowledged segments
+    //!@{
+    uint64_t delivered = 0;            //!< Total bytes delivered, including this ACK
+    uint64_t prior_delivered = 0;      //!< Total bytes delivered when that segment was sent
+    uint64_t delivery_rate = 0;        //!< Bytes per second over that segment's flight (0 if too short to tell)
+    std::optional<uint64_t> rtt_ms{};  //!< Round-trip time, by timestamp echo or (unless retransmitted) that segment's
+    bool app_limited = false;          //!< The application, not the network, limited the sample
+    //!@}
+
+    bool in_recovery = false;  //!< The sender was in fast recovery when the ACK arrived (cwnd should not grow)
+    bool ece = false;          //!< The ACK carried ECN-Echo: the receiver saw congestion marks (RFC 3168)
+};
+
+//! \brief The congestion-control policy of a TCPSender
+//!
+//! The sender never has more than min(cwnd(), receiver window) bytes in flight,
+//! and reports acknowledgments and losses through the `on_*` hooks.
+//! All sizes are in bytes of sequence space.
+class CongestionController {
+  public:
+    //! The available algorithms (see TCPConfig::congestion_control)
+    enum class Algorithm {
+        None,     //!< Flow control only: the window is whatever the receiver advertises
+        NewReno,  //!< Slow start and congestion avoidance (RFC 5681 / RFC 6582)
+        Cubic,    //!< CUBIC window growth for high bandwidth-delay products (RFC 8312, see CubicController)
+        BBR,      //!< Model-based: paces at the estimated bottleneck bandwidth (see BBRController)
+        DCTCP     //!< NewReno, but cut in proportion to the ECN marks (RFC 8257, see DCTCPController); needs ECN
+    };
+
+    //! \brief Make a controller for `algorithm`
+    //! \param mss is the largest payload the sender puts in a segment
+    static std::unique_ptr<CongestionController> make(const Algorithm algorithm, const size_t mss);
+
+    virtual ~CongestionController() = default;
+
+    //! The congestion window
+    virtual size_t cwnd() const = 0;
+
+    //! \brief The rate at which segments should be released, in bytes per second
+    //! \returns 0 if the controller does not ask for pacing
+    virtual uint64_t pacing_rate() const { return 0; }
+
+    //! An ACK acknowledged new data
+    virtual void on_ack(const AckSample &sample) = 0;
+
+    //! A segment was detected lost without a timeout (e.g., by duplicate ACKs)
+    virtual void on_loss(const size_t bytes_in_flight, const uint64_t now_ms) = 0;
+
+    //! The retransmission timer expired
+    virtual void on_rto(const size_t bytes_in_flight, const uint64_t now_ms) = 0;
+
+    //! \brief An ACK echoed congestion marks (at most once per window)
+    //! \details By default, the window is reduced as for a loss (RFC 3168), though nothing was lost
+    virtual void on_ecn(const size_t bytes_in_flight, const uint64_t now_ms) { on_loss(bytes_in_flight, now_ms); }
+};
+
+//! \brief No congestion control at all: the window is unlimited
+class UnlimitedController : public CongestionController {
+  public:
+    size_t cwnd() const override;
+    void on_ack(const AckSample &) override {}
+    void on_loss(const size_t, const uint64_t) override {}
+    void on_rto(const size_t, const uint64_t) override {}
+    void on_ecn(const size_t, const uint64_t) override {}
+};
+
+//! \brief NewReno window management: slow start below `ssthresh`, then one MSS per RTT
+class NewRenoController : public CongestionController {
+  private:
+    size_t _mss;
+    size_t _cwnd;
+    size_t _ssthresh;
+    size_t _acked_in_avoidance = 0;  //!< Bytes acknowledged since cwnd last grew in congestion avoidance
+
+  protected:
+    //! Continue in congestion avoidance from a window of `cwnd` bytes (at least two segments)
+    void _reduce_to(const size_t cwnd);
+
+  public:
+    //! The initial window, in segments (RFC 6928)
+    static constexpr size_t INITIAL_WINDOW = 10;
+
+    explicit NewRenoController(const size_t mss);
+
+    size_t cwnd() const override { return _cwnd; }
+    void on_ack(const AckSample &sample) override;
+    void on_loss(const size_t bytes_in_flight, const uint64_t now_ms) override;
+    void on_rto(const size_t bytes_in_flight, const uint64_t now_ms) override;
+
+    //! The slow-start threshold
+    size_t ssthresh() const { return _ssthresh; }
+};
+
+#endif  // SPONGE_LIBSPONGE_CONGESTION_CONTROLLER_HH
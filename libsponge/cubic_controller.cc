@@ -0,0 +1,72 @@
+#include "cubic_controller.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+CubicController::CubicController(const size_t mss)
+    : _mss(mss)
+    , _cwnd(static_cast<double>(NewRenoController::INITIAL_WINDOW))
+    , _ssthresh(numeric_limits<double>::infinity()) {}
+
+void CubicController::on_ack(const AckSample &sample) {
+    if (sample.in_recovery) {
+        return;
+    }
+    auto acked = static_cast<double>(sample.acked_bytes) / static_cast<double>(_mss);
+    if (_cwnd < _ssthresh) {
+        const auto growth = min(acked, _ssthresh - _cwnd);
+        _cwnd += growth;
+        acked -= growth;  // whatever is left over counts toward congestion avoidance
+        if (acked <= 0) {
+            return;
+        }
+    }
+
+    if (not _epoch_start_ms.has_value()) {
+        // start a new epoch; after a timeout the window may start far below W_max
+        _epoch_start_ms = sample.now_ms;
+        if (_cwnd < _w_max) {
+            _k = cbrt((_w_max - _cwnd) / C);
+        } else {
+            _k = 0;
+            _w_max = _cwnd;
+        }
+        _w_est = _cwnd;
+    }
+
+    const auto t = static_cast<double>(sample.now_ms - _epoch_start_ms.value()) / 1000.0;
+    const auto target = C * pow(t - _k, 3) + _w_max;
+    if (target > _cwnd) {
+        // (target - cwnd) / cwnd per acknowledged segment, but at most 1.5x per RTT (as Linux does)
+        _cwnd += min((target - _cwnd) / _cwnd, 0.5) * acked;
+    }
+
+    _w_est += ALPHA * acked / _cwnd;
+    _cwnd = max(_cwnd, _w_est);
+}
+
+//! \details The window in use is the smaller of cwnd and what was actually in flight: while the
+//! receiver's window is the limit, cwnd keeps growing without ever being tested.
+//! With fast convergence, a flow whose window had not even got back to the previous
+//! W_max gives up more, releasing bandwidth to newer flows.
+void CubicController::_reduce(const size_t bytes_in_flight) {
+    const auto window = min(_cwnd, static_cast<double>(bytes_in_flight) / static_cast<double>(_mss));
+    _w_max = window < _w_max ? window * (1 + BETA) / 2 : window;
+    _ssthresh = max(window * BETA, 2.0);
+    _epoch_start_ms.reset();
+}
+
+void CubicController::on_loss(const size_t bytes_in_flight, const uint64_t) {
+    _reduce(bytes_in_flight);
+    _cwnd = _ssthresh;
+}
+
+void CubicController::on_rto(const size_t bytes_in_flight, const uint64_t) {
+    if (_cwnd > 1) {  // don't shrink W_max again on a backed-off retransmission
+        _reduce(bytes_in_flight);
+    }
+    _cwnd = 1;
+}
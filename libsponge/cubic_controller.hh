@@ -0,0 +1,55 @@
+#ifndef SPONGE_LIBSPONGE_CUBIC_CONTROLLER_HH
+#define SPONGE_LIBSPONGE_CUBIC_CONTROLLER_HH
+
+#include "congestion_controller.hh"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+//! \brief CUBIC congestion control (RFC 8312)
+//!
+//! After a reduction, the window follows W(t) = C (t - K)^3 + W_max, where t is the time
+//! since the window started growing again and K is when W(t) gets back to W_max. Growth is
+//! therefore fast far from W_max, flat near it, and independent of the RTT. Where Reno-style
+//! growth would be faster (short RTTs, small windows), the window follows that instead.
+//! Windows are kept in (fractional) segments internally.
+class CubicController : public CongestionController {
+  private:
+    size_t _mss;
+    double _cwnd;                              //!< Congestion window
+    double _ssthresh;                          //!< Slow-start threshold
+    double _w_max = 0;                         //!< Window just before the last reduction
+    double _k = 0;                             //!< Seconds from the epoch start until W(t) reaches _w_max
+    double _w_est = 0;                         //!< Window a Reno flow would have now (TCP-friendly region)
+    std::optional<uint64_t> _epoch_start_ms{};  //!< When the window started growing after the last reduction
+
+    //! Remember the window before a reduction, and lower ssthresh
+    void _reduce(const size_t bytes_in_flight);
+
+  public:
+    static constexpr double C = 0.4;     //!< Scaling constant, in segments / second^3
+    static constexpr double BETA = 0.7;  //!< Multiplicative decrease factor
+    //! Reno-equivalent additive increase for BETA, in segments per RTT
+    static constexpr double ALPHA = 3 * (1 - BETA) / (1 + BETA);
+
+    explicit CubicController(const size_t mss);
+
+    size_t cwnd() const override { return static_cast<size_t>(_cwnd * static_cast<double>(_mss)); }
+    void on_ack(const AckSample &sample) override;
+    void on_loss(const size_t bytes_in_flight, const uint64_t now_ms) override;
+    void on_rto(const size_t bytes_in_flight, const uint64_t now_ms) override;
+
+    //! The slow-start threshold, in bytes (the largest size_t until the first reduction sets one)
+    size_t ssthresh() const {
+        return std::isinf(_ssthresh) ? std::numeric_limits<size_t>::max()
+                                : static_cast<size_t>(_ssthresh * static_cast<double>(_mss));
+    }
+
+    //! The window before the last reduction, in bytes
+    size_t w_max() const { return static_cast<size_t>(_w_max * static_cast<double>(_mss)); }
+};
+
+#endif  // SPONGE_LIBSPONGE_CUBIC_CONTROLLER_HH
@@ -0,0 +1,25 @@
+#include "dctcp_controller.hh"
+
+using namespace std;
+
+//! \details An observation window lasts until the data in flight at its start has been delivered,
+//! about a round trip. Marks are counted even in recovery, when the window itself does not grow.
+void DCTCPController::on_ack(const AckSample &sample) {
+    _acked_in_window += sample.acked_bytes;
+    if (sample.ece) {
+        _marked_in_window += sample.acked_bytes;
+    }
+    if (not _window_end.has_value() or sample.delivered >= _window_end.value()) {
+        if (_window_end.has_value() and _acked_in_window > 0) {
+            const auto fraction = static_cast<double>(_marked_in_window) / static_cast<double>(_acked_in_window);
+            _alpha = (1 - G) * _alpha + G * fraction;
+        }
+        _acked_in_window = _marked_in_window = 0;
+        _window_end = sample.delivered + sample.bytes_in_flight;
+    }
+    NewRenoController::on_ack(sample);
+}
+
+void DCTCPController::on_ecn(const size_t, const uint64_t) {
+    _reduce_to(static_cast<size_t>(static_cast<double>(cwnd()) * (1 - _alpha / 2)));
+}
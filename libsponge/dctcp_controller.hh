@@ -0,0 +1,36 @@
+#ifndef SPONGE_LIBSPONGE_DCTCP_CONTROLLER_HH
+#define SPONGE_LIBSPONGE_DCTCP_CONTROLLER_HH
+
+#include "congestion_controller.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+//! \brief DCTCP congestion control (RFC 8257)
+//!
+//! Switches that mark packets CE once their queue passes a small threshold give a receiver an
+//! early, graded signal of congestion, which it echoes exactly (not latched until CWR). Once per
+//! window of data the sender updates `alpha`, a moving average of the fraction of bytes that were
+//! marked, and an ECN reduction cuts the window by alpha / 2: a lightly marked window costs little,
+//! and a fully marked one halves it, as for a loss. Growth, and the response to real losses, are NewReno's.
+class DCTCPController : public NewRenoController {
+  private:
+    double _alpha = 1;                        //!< Estimated fraction of marked bytes (starts pessimistic)
+    uint64_t _acked_in_window = 0;            //!< Bytes acknowledged in the current observation window
+    uint64_t _marked_in_window = 0;           //!< ... by ACKs carrying ECE
+    std::optional<uint64_t> _window_end{};    //!< The window ends once this many bytes have been delivered
+
+  public:
+    static constexpr double G = 1.0 / 16;  //!< Gain of the alpha filter
+
+    explicit DCTCPController(const size_t mss) : NewRenoController(mss) {}
+
+    void on_ack(const AckSample &sample) override;
+    void on_ecn(const size_t bytes_in_flight, const uint64_t now_ms) override;
+
+    //! The estimated fraction of bytes marked
+    double alpha() const { return _alpha; }
+};
+
+#endif  // SPONGE_LIBSPONGE_DCTCP_CONTROLLER_HH
@@ -59,7 +59,8 @@ void NetworkInterface::send_datagram(const InternetDatagram &dgram, const Addres
             arp_request.target_ip_address = next_hop_ip;
             _send(ETHERNET_BROADCAST, EthernetHeader::TYPE_ARP, arp_request.serialize());
             // add the ip address to the waiting list (will create a new entry if not already there)
-            _waiting_arp_response_ip_addr[next_hop_ip] = ARP_RESPONSE_TTL_MS;
+            _waiting_arp_response_ip_addr[next_hop_ip] =
+                _timers.arm(ARP_RESPONSE_TTL_MS, _timer_key(TimerKind::Request, next_hop_ip));
         }
         // add the datagram to the waiting list
         _waiting_internet_datagrams[next_hop_ip].emplace_back(next_hop, dgram);
@@ -92,7 +93,9 @@ optional<InternetDatagram> NetworkInterface::recv_frame(const EthernetFrame &fra
         // case 2: ARP request not sent to this interface
         // case 3: ARP reply sent to this interface
         // for all three cases: remember the IP-MAC mapping learned from the ARP broadcasts for 30 secs, no matter if its request or reply
-        _arp_table[src_ip] = {arp_request.sender_ethernet_address,  ARP_ENTRY_TTL_MS};
+        auto &entry = _arp_table[src_ip];
+        entry.eth_addr = arp_request.sender_ethernet_address;
+        entry.expiry = _timers.rearm(entry.expiry, ARP_ENTRY_TTL_MS, _timer_key(TimerKind::Entry, src_ip));
 
         // case 1: reply with the MAC address
         if (arp_request.opcode == ARPMessage::OPCODE_REQUEST && arp_request.target_ip_address == my_ip) {
@@ -120,26 +123,14 @@ optional<InternetDatagram> NetworkInterface::recv_frame(const EthernetFrame &fra
 
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void NetworkInterface::tick(const size_t ms_since_last_tick) {
-    // delete expired ARP table entries
-    for (auto it = _arp_table.begin(); it != _arp_table.end(); ) {
-        if (it -> second.ttl <= ms_since_last_tick) { 
-            it = _arp_table.erase(it); // delete entry and move to next
+    _timers.advance(ms_since_last_tick, [&](const uint64_t key) {
+        const auto ip = static_cast<uint32_t>(key);
+        if (static_cast<TimerKind>(key >> 32) == TimerKind::Entry) {
+            _arp_table.erase(ip); // delete the expired entry
         } else {
-            it -> second.ttl -= ms_since_last_tick; // update TTL
-            it = std::next(it);
+            // discard the datagrams waiting for the ARP response if timeout
+            _waiting_internet_datagrams.erase(ip);
+            _waiting_arp_response_ip_addr.erase(ip);
         }
-    }
-    
-    // discard the datagrams waiting for the ARP response if timeout
-    for (auto it = _waiting_arp_response_ip_addr.begin(); it != _waiting_arp_response_ip_addr.end(); ) {
-        if (it -> second <= ms_since_last_tick) { // if timeout
-            auto it2 = _waiting_internet_datagrams.find(it -> first);
-            if (it2 != _waiting_internet_datagrams.end()) // discard the datagrams of the corresponding IP address
-                _waiting_internet_datagrams.erase(it2);
-            it = _waiting_arp_response_ip_addr.erase(it);
-        } else {
-            it -> second -= ms_since_last_tick;
-            it = std::next(it);
-        }
-    }
-}
\ No newline at end of file
+    });
+}
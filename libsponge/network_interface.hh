@@ -5,6 +5,7 @@
 #include "ethernet_frame.hh"
 #include "ethernet_header.hh"
 #include "tcp_over_ip.hh"
+#include "timing_wheel.hh"
 #include "tun.hh"
 
 #include <cstddef>
@@ -39,10 +40,20 @@ class NetworkInterface {
   private:
     //! ARP table entry
     struct ARPEntry {
-      EthernetAddress eth_addr;
-      size_t ttl; // time to live
+      EthernetAddress eth_addr{};
+      TimingWheel::TimerId expiry{}; // removes the entry when it goes off
     };
 
+    //! What a timer in _timers is for; the key is the kind in the high word and the IP address in the low one
+    enum class TimerKind : uint64_t { Entry = 0, Request = 1 };
+
+    static uint64_t _timer_key(const TimerKind kind, const uint32_t ip) {
+        return static_cast<uint64_t>(kind) << 32 | ip;
+    }
+
+    //! Expiry of ARP entries and pending requests: a tick only touches the ones that expire
+    TimingWheel _timers{};
+
     //! Ethernet (known as hardware, network-access-layer, or link-layer) address of the interface
     EthernetAddress _ethernet_address;
 
@@ -58,8 +69,8 @@ class NetworkInterface {
     //! IP datagrams waiting for ARP response to the IP address; will be sent after ARP response received
     std::unordered_map<uint32_t, std::list<std::pair<Address, InternetDatagram>>> _waiting_internet_datagrams{};
 
-    //! the expiration time of the IP datagrams above
-    std::unordered_map<uint32_t, size_t> _waiting_arp_response_ip_addr{};
+    //! the expiration timers of the IP datagrams above (no new request is sent for an address until then)
+    std::unordered_map<uint32_t, TimingWheel::TimerId> _waiting_arp_response_ip_addr{};
 
     //! send the ethernet frame right away if the destination is known
     void _send(const EthernetAddress &dst, const uint16_t type, BufferList &&payload);
@@ -0,0 +1,89 @@
+#include "retransmission_queue.hh"
+
+#include <utility>
+
+using namespace std;
+
+//! Smallest power of two that is at least `n` (and at least 1)
+static size_t round_up_to_power_of_two(const size_t n) {
+    size_t power = 1;
+    while (power < n) {
+        power *= 2;
+    }
+    return power;
+}
+
+RetransmissionQueue::RetransmissionQueue(const size_t capacity) : _slots(round_up_to_power_of_two(capacity)) {}
+
+void RetransmissionQueue::_grow() {
+    vector<OutstandingSegment> slots(2 * _slots.size());
+    for (size_t i = 0; i < _size; ++i) {
+        slots[i] = move(_slot(i));
+    }
+    _slots = move(slots);
+    _head = 0;
+}
+
+OutstandingSegment &RetransmissionQueue::push_back() {
+    if (_size == _slots.size()) {
+        _grow();
+    }
+    return _slot(_size++);
+}
+
+void RetransmissionQueue::pop_front(const size_t n) {
+    for (size_t i = 0; i < n and _size > 0; ++i) {
+        _slot(0) = OutstandingSegment{};  // drop the payload now, and leave the slot clear for push_back
+        _head = (_head + 1) & (_slots.size() - 1);
+        --_size;
+    }
+    _prune();
+}
+
+//! \details Ends increase from the front, so this is a binary search for the first segment ending after `abs_seqno`
+size_t RetransmissionQueue::count_ending_by(const uint64_t abs_seqno) const {
+    size_t low = 0, high = _size;
+    while (low < high) {
+        const auto mid = low + (high - low) / 2;
+        if (_slot(mid).end() <= abs_seqno) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+size_t RetransmissionQueue::find_starting_from(const uint64_t abs_seqno) const {
+    size_t low = 0, high = _size;
+    while (low < high) {
+        const auto mid = low + (high - low) / 2;
+        if (_slot(mid).abs_seqno < abs_seqno) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+OutstandingSegment *RetransmissionQueue::_find(const TransmitRecord &record) {
+    // the segment ending at `end` is the first one that ends after end - 1
+    const auto i = count_ending_by(record.end - 1);
+    if (i == _size) {
+        return nullptr;
+    }
+    auto &out = _slot(i);
+    return out.end() == record.end && out.xmit_ms == record.xmit_ms && !out.sacked ? &out : nullptr;
+}
+
+void RetransmissionQueue::_prune() {
+    while (!_transmissions.empty() && _find(_transmissions.front()) == nullptr) {
+        _transmissions.pop_front();
+    }
+}
+
+void RetransmissionQueue::transmitted(OutstandingSegment &out, const uint64_t now_ms) {
+    out.xmit_ms = now_ms;
+    _transmissions.push_back({out.end(), now_ms});
+}
@@ -0,0 +1,121 @@
+#ifndef SPONGE_LIBSPONGE_RETRANSMISSION_QUEUE_HH
+#define SPONGE_LIBSPONGE_RETRANSMISSION_QUEUE_HH
+
+#include "tcp_segment.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+//! \brief A segment sent but not yet acknowledged, with the state needed for delivery-rate samples
+//! (see draft-cheng-iccrg-delivery-rate-estimation)
+struct OutstandingSegment {
+    uint64_t abs_seqno = 0;      //!< Absolute seqno of the segment's first byte
+    TCPSegment segment{};
+    uint64_t sent_ms = 0;        //!< When the segment was sent
+    uint64_t xmit_ms = 0;        //!< When the segment was last sent, counting retransmissions (RACK's xmit_ts)
+    uint64_t delivered = 0;      //!< The sender's delivered count when the segment was sent
+    uint64_t delivered_ms = 0;   //!< When that count last grew
+    uint64_t first_sent_ms = 0;  //!< Send time of the segment whose ACK last grew the count
+    bool app_limited = false;    //!< Sent while the application had nothing more to send
+    bool retransmitted = false;  //!< Retransmitted at least once, so its ACK gives no RTT sample (Karn)
+
+    //! \name SACK scoreboard (RFC 6675)
+    //!@{
+    bool sacked = false;              //!< Covered by a SACK block: the receiver holds it
+    bool lost = false;                //!< Enough data after it has been SACKed to deem it lost
+    bool lost_retransmitted = false;  //!< Retransmitted since it was deemed lost, so back in the pipe
+    //!@}
+
+    //! Absolute seqno just past the segment
+    uint64_t end() const { return abs_seqno + segment.length_in_sequence_space(); }
+};
+
+//! \brief The outstanding segments of a TCPSender, oldest first, in a ring of reusable slots
+//!
+//! Segments are appended in sequence order and leave from the front, so the ring is sorted
+//! by absolute seqno and cumulative and selective ACKs find their segments by binary search.
+//! Slots are preallocated and recycled; the ring only grows (doubling) if it fills up.
+//!
+//! Retransmissions break the order of send times, so the queue also keeps a record of every
+//! transmission, oldest first, for RACK (RFC 8985) to walk in time order.
+class RetransmissionQueue {
+  private:
+    //! A transmission of the segment ending at `end`; it is stale once that segment is
+    //! acknowledged, SACKed or sent again
+    struct TransmitRecord {
+        uint64_t end;
+        uint64_t xmit_ms;
+    };
+
+    std::vector<OutstandingSegment> _slots;  //!< A power-of-two number of slots; unused ones are default
+    size_t _head = 0;                        //!< Slot of the oldest segment
+    size_t _size = 0;                        //!< Number of outstanding segments
+    std::deque<TransmitRecord> _transmissions{};  //!< Oldest first; stale records are dropped from the front
+
+    //! The segment a record is of, or nullptr if the record is stale
+    OutstandingSegment *_find(const TransmitRecord &record);
+
+    //! Drop the stale records at the front
+    void _prune();
+
+    OutstandingSegment &_slot(const size_t i) { return _slots[(_head + i) & (_slots.size() - 1)]; }
+    const OutstandingSegment &_slot(const size_t i) const { return _slots[(_head + i) & (_slots.size() - 1)]; }
+
+    //! Double the number of slots, moving the segments to the front
+    void _grow();
+
+  public:
+    //! Slots allocated up front: a full 16-bit window of full-size segments
+    static constexpr size_t DEFAULT_CAPACITY = 64;
+
+    //! \param capacity is rounded up to a power of two
+    explicit RetransmissionQueue(const size_t capacity = DEFAULT_CAPACITY);
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    //! Slots allocated, used or not
+    size_t capacity() const { return _slots.size(); }
+
+    //! \name The `i`th oldest outstanding segment
+    //!@{
+    OutstandingSegment &operator[](const size_t i) { return _slot(i); }
+    const OutstandingSegment &operator[](const size_t i) const { return _slot(i); }
+    OutstandingSegment &front() { return _slot(0); }
+    const OutstandingSegment &front() const { return _slot(0); }
+    //!@}
+
+    //! \brief Append a segment
+    //! \returns a cleared slot after the newest segment, for the caller to fill in
+    OutstandingSegment &push_back();
+
+    //! Remove the `n` oldest segments, releasing their payloads
+    void pop_front(const size_t n = 1);
+
+    //! \brief Number of segments, from the oldest, that end at or before `abs_seqno`
+    //! \details These are the segments a cumulative ACK of `abs_seqno` acknowledges.
+    size_t count_ending_by(const uint64_t abs_seqno) const;
+
+    //! Index of the oldest segment that starts at or after `abs_seqno` (size() if there is none)
+    size_t find_starting_from(const uint64_t abs_seqno) const;
+
+    //! \brief Record that `out`, one of the outstanding segments, has just been sent (again) at `now_ms`
+    void transmitted(OutstandingSegment &out, const uint64_t now_ms);
+
+    //! \brief Call `visit` on the outstanding segments that are not SACKed, least recently sent first,
+    //! until it returns false
+    template <typename Visit>
+    void for_each_by_transmission(Visit &&visit) {
+        _prune();
+        for (const auto &record : _transmissions) {
+            auto *out = _find(record);
+            if (out != nullptr and not visit(*out)) {
+                return;
+            }
+        }
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_RETRANSMISSION_QUEUE_HH
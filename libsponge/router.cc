@@ -52,6 +52,13 @@ void Router::route_one_datagram(InternetDatagram &dgram) {
     if (best_match != _routing_table.end() && dgram.header().ttl > 1) {
         --dgram.header().ttl; // decrement the TTL of IP datagram to prevent infinite routing loops
         auto &next_interface = interface(best_match -> interface_num); // find the correct interface to send the datagram
+        // a congested queue marks ECN-capable datagrams rather than waiting to drop them
+        if (_ecn_marking_threshold.has_value() &&
+            next_interface.frames_out().size() >= _ecn_marking_threshold.value() &&
+            dgram.header().ecn() != IPv4Header::ECN::NotECT) {
+            if (dgram.header().ecn() != IPv4Header::ECN::CE) ++_ecn_marked;
+            dgram.header().set_ecn(IPv4Header::ECN::CE);
+        }
         // send to the next hop if it exists, otherwise send to the destination directly
         if (best_match -> next_hop.has_value()) {
             next_interface.send_datagram(dgram, best_match -> next_hop.value());
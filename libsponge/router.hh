@@ -68,6 +68,12 @@ class Router {
     //! The table of route entries
     std::vector<RouteEntry> _routing_table{};
 
+    //! Queue length, in frames, from which ECN-capable datagrams are marked CE (empty: never)
+    std::optional<size_t> _ecn_marking_threshold{};
+
+    //! Datagrams marked CE
+    uint64_t _ecn_marked = 0;
+
     //! Send a single datagram from the appropriate outbound interface to the next hop,
     //! as specified by the route with the longest prefix_length that matches the
     //! datagram's destination address.
@@ -91,6 +97,15 @@ class Router {
                    const std::optional<Address> next_hop,
                    const size_t interface_num);
 
+    //! \brief Mark ECN-capable datagrams CE (RFC 3168) when the outbound interface already has `frames`
+    //! frames queued, instead of letting the queue grow until something has to drop them
+    //! \details A low threshold on the instantaneous queue is what DCTCP (RFC 8257) expects of a switch.
+    //! Datagrams that are not ECN-capable pass unmarked. An empty `frames` turns marking off.
+    void set_ecn_marking_threshold(const std::optional<size_t> frames) { _ecn_marking_threshold = frames; }
+
+    //! Number of datagrams marked CE
+    uint64_t ecn_marked() const { return _ecn_marked; }
+
     //! Route packets between the interfaces
     void route();
 };
@@ -1,6 +1,7 @@
 #include "stream_reassembler.hh"
-#include <string>
+#include <cstring>
 #include <limits>
+#include <string>
 
 // Dummy implementation of a stream reassembler.
 
@@ -14,8 +15,13 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-StreamReassembler::StreamReassembler(const size_t capacity) : _output(capacity), _capacity(capacity), 
-                                                              _stream(capacity), _exp_index(0),
+StreamReassembler::StreamReassembler(const size_t capacity, const bool double_mapped, const Engine engine)
+                                                            : _output(capacity, double_mapped), _capacity(capacity),
+                                                              _engine(engine),
+                                                              _stream(engine == Engine::Bitmap ? capacity : 0,
+                                                                      double_mapped),
+                                                              _occupancy(engine == Engine::Bitmap ? capacity : 0),
+                                                              _exp_index(0),
                                                               _eof_index(std::numeric_limits<size_t>::max()), 
                                                               _num_bytes_unassembled(0) {}
  
@@ -23,33 +29,168 @@ StreamReassembler::StreamReassembler(const size_t capacity) : _output(capacity),
 //! possibly out-of-order, from the logical stream, and assembles any newly
 //! contiguous substrings and writes them into the output stream in order.
 void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
+    _push(nullptr, data, index, eof);
+}
+
+void StreamReassembler::push_substring(const Buffer &data, const size_t index, const bool eof) {
+    _push(&data, data, index, eof);
+}
+
+void StreamReassembler::_push(const Buffer *owner, const string_view data, const uint64_t index, const bool eof) {
     if (eof) _eof_index = min(_eof_index, index + data.size());
 
-    auto left = max(index, _exp_index); // the left bound of the segment
-    auto right = min(index + data.size(), min(_exp_index - _output.buffer_size() + _capacity, _eof_index)); // the right bound of the segment, constrained by data size, capacity index, and eof
-    
-    for (size_t i = left, j = left - index; i < right; ++i, ++j) { // j is the first non-overlapped index of the substring
-        auto &t = _stream[i % _capacity];
-        if (t.second == true) { // already occupied
-            if (t.first != data[j]) return; // discard if the segment is inconsistent 
-            // do nothing if overlapped
+    const auto left = max(index, _exp_index); // the left bound of the segment
+    const auto right = min(index + data.size(), min(_exp_index - _output.buffer_size() + _capacity, _eof_index)); // the right bound of the segment, constrained by data size, capacity index, and eof
+
+    if (_engine == Engine::Bitmap) {
+        _push_bitmap(data, index, left, right);
+    } else {
+        _push_interval(owner, data, index, left, right);
+    }
+
+    if (_exp_index >= _eof_index) _output.end_input();
+}
+
+//! \details Pending bytes live in `_pending` as non-overlapping slices. A new segment only fills
+//! the gaps between the slices it overlaps (bytes that arrived first win), so the cost
+//! is O(log n) to find its place plus one step per slice it overlaps, never per byte.
+void StreamReassembler::_push_interval(
+    const Buffer *owner, const string_view data, const uint64_t index, uint64_t left, const uint64_t right) {
+    // skip the part already covered by the slice starting before `left`
+    auto it = _pending.upper_bound(left);
+    if (it != _pending.begin()) {
+        const auto prev = std::prev(it);
+        left = max(left, prev->first + prev->second.size());
+    }
+
+    while (left < right) {
+        if (it != _pending.end() and it->first <= left) { // overlapped by an existing slice
+            left = max(left, it->first + it->second.size());
+            ++it;
+            continue;
+        }
+        const auto gap_end = it == _pending.end() ? right : min(right, it->first);
+        const auto offset = left - index, len = gap_end - left;
+        if (left == _exp_index) { // in order: straight into the output stream
+            if (owner) {
+                _output.write(owner->substr(offset, len));
+            } else {
+                _output.write(data.substr(offset, len));
+            }
+            _exp_index = gap_end;
         } else {
-            t = make_pair(data[j], true);
-            ++_num_bytes_unassembled;
+            // as in ByteStream::write(Buffer), a slice much smaller than its storage is copied, so that
+            // the storage held by pending bytes stays within MAX_PIN_RATIO times their number
+            const bool keep_slice = owner and len * ByteStream::MAX_PIN_RATIO >= owner->storage_size();
+            _pending.emplace_hint(
+                it, left, keep_slice ? owner->substr(offset, len) : Buffer{string(data.substr(offset, len))});
+            _num_bytes_unassembled += len;
         }
+        left = gap_end;
     }
-    
-    string str;
-    while (_exp_index < _eof_index && _stream[_exp_index % _capacity].second == true) { // pop out as long as it's contiguous
-        str.push_back(_stream[_exp_index % _capacity].first); 
-        _stream[_exp_index % _capacity] = { 0, false }; // clear the room for future use
-        --_num_bytes_unassembled, ++_exp_index;
+
+    // hand every slice that is now contiguous to the output stream, without copying it
+    while (not _pending.empty() and _pending.begin()->first == _exp_index) {
+        const auto size = _pending.begin()->second.size();
+        _output.write(move(_pending.begin()->second));
+        _exp_index += size;
+        _num_bytes_unassembled -= size;
+        _pending.erase(_pending.begin());
     }
-    _output.write(str);
+}
 
-    if (_exp_index >= _eof_index) _output.end_input();
+//! \details Like the original per-byte reassembler, a segment whose bytes disagree with bytes
+//! already held is kept only up to the first disagreement. The check, the occupancy
+//! updates and the search for the contiguous run all work on whole bitmap words or
+//! SIMD registers at a time. Ranges that wrap around the ring are handled in two pieces.
+void StreamReassembler::_push_bitmap(const string_view data,
+                                     const uint64_t index,
+                                     const uint64_t left,
+                                     const uint64_t right) {
+    if (left < right) {
+        const char *src = data.data() + (left - index);
+        const auto pos = left % _capacity;
+        const auto first = min<size_t>(right - left, _capacity - pos); // the part before the wrap point
+        auto len = _occupancy.first_conflict(pos, _stream.data() + pos, src, first);
+        if (len == first) {
+            len += _occupancy.first_conflict(0, _stream.data(), src + first, right - left - first);
+        }
+
+        for (size_t done = 0; done < len;) { // at most two pieces
+            const auto slot = (pos + done) % _capacity;
+            const auto n = min(len - done, _capacity - slot);
+            _num_bytes_unassembled += n - _occupancy.count(slot, n);
+            memcpy(_stream.data() + slot, src + done, n);
+            _occupancy.set(slot, n);
+            done += n;
+        }
+    }
+
+    // find the contiguous run starting at _exp_index, clearing the room for future use
+    if (_capacity == 0) return;
+    const auto start = _exp_index % _capacity;
+    auto run = _occupancy.run_length(start, _capacity - start);
+    if (start + run == _capacity) {
+        run += _occupancy.run_length(0, start);
+    }
+    const auto first = min(run, _capacity - start);
+    _occupancy.clear(start, first);
+    _occupancy.clear(0, run - first);
+
+    // hand the run to the output stream; a double-mapped ring never wraps, otherwise it takes at most two writes
+    if (_stream.double_mapped()) {
+        _output.write(string_view{_stream.data() + start, run});
+    } else {
+        _output.write(string_view{_stream.data() + start, first});
+        _output.write(string_view{_stream.data(), run - first});
+    }
+    _num_bytes_unassembled -= run;
+    _exp_index += run;
 }
  
+//! \details The bitmap engine alternates between runs of used and free slots, which takes
+//! two scans per hole; the walk stops once every unassembled byte has been found.
+size_t StreamReassembler::pending_storage() const {
+    size_t total = 0;
+    for (const auto &entry : _pending) {
+        total += entry.second.storage_size();
+    }
+    return total;
+}
+
+vector<pair<uint64_t, uint64_t>> StreamReassembler::pending_ranges() const {
+    vector<pair<uint64_t, uint64_t>> ranges;
+    const auto add = [&](const uint64_t first, const uint64_t last) {
+        if (not ranges.empty() and ranges.back().second == first) {
+            ranges.back().second = last;
+        } else {
+            ranges.emplace_back(first, last);
+        }
+    };
+
+    if (_engine == Engine::Interval) {
+        for (const auto &[index, slice] : _pending) {
+            add(index, index + slice.size());
+        }
+        return ranges;
+    }
+
+    size_t found = 0;
+    for (uint64_t index = _exp_index; found < _num_bytes_unassembled and index < _exp_index + _capacity;) {
+        const auto pos = index % _capacity;
+        const auto limit = min<uint64_t>(_exp_index + _capacity - index, _capacity - pos); // stop at the ring's end
+        const auto used = _occupancy.run_length(pos, limit);
+        if (used > 0) {
+            add(index, index + used);
+            found += used;
+            index += used;
+        } else {
+            index += _occupancy.gap_length(pos, limit);
+        }
+    }
+    return ranges;
+}
+
 size_t StreamReassembler::unassembled_bytes() const { return _num_bytes_unassembled; }
  
 bool StreamReassembler::empty() const { return unassembled_bytes() == 0; }
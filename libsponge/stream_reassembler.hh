@@ -1,31 +1,61 @@
 #ifndef SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
 #define SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
 
+#include "buffer.hh"
 #include "byte_stream.hh"
+#include "occupancy_bitmap.hh"
+#include "ring_storage.hh"
 
 #include <cstdint>
+#include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 //! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
 //! possibly overlapping) into an in-order byte stream.
 class StreamReassembler {
+  public:
+    //! How bytes waiting to be assembled are stored
+    enum class Engine {
+        Interval,  //!< An ordered map of non-overlapping slices
+        Bitmap     //!< A flat ring of bytes plus a packed occupancy bitmap, scanned with SIMD
+    };
+
   private:
     // Your code here -- add private members as necessary.
 
     ByteStream _output;  //!< The reassembled in-order byte stream
     size_t _capacity;    //!< The maximum number of bytes
     
-    std::vector<std::pair<char, bool> > _stream; // a (circular) buffer to hold the bytes; the second element indicates whether the byte is occupied
+    Engine _engine;
+    // Engine::Interval: non-overlapping slices waiting to be assembled, keyed by stream index
+    std::map<uint64_t, Buffer> _pending{};
+    RingStorage _stream;          // Engine::Bitmap: a (circular) buffer to hold the bytes
+    OccupancyBitmap _occupancy;   // Engine::Bitmap: whether each slot of _stream holds a byte
     size_t _exp_index;   //!< The index of the first byte of the reassembled byte stream
     size_t _eof_index;         // the index where everything stops
     size_t _num_bytes_unassembled;
+
+    //! Common part of both push_substring overloads; `owner`, if given, holds the bytes of `data`
+    void _push(const Buffer *owner, const std::string_view data, const uint64_t index, const bool eof);
+
+    //! Store the bytes [left, right) of `data` (which starts at `index`) with the interval engine,
+    //! as slices of `owner` if given and as copies otherwise
+    void _push_interval(
+        const Buffer *owner, const std::string_view data, const uint64_t index, uint64_t left, const uint64_t right);
+
+    //! Store the bytes [left, right) of `data` (which starts at `index`) with the bitmap engine
+    void _push_bitmap(const std::string_view data, const uint64_t index, const uint64_t left, const uint64_t right);
  
   public:
     //! \brief Construct a `StreamReassembler` that will store up to `capacity` bytes.
     //! \note This capacity limits both the bytes that have been reassembled,
     //! and those that have not yet been reassembled.
-    StreamReassembler(const size_t capacity);
+    //! \param double_mapped requests magic-ring storage (see RingStorage) for the
+    //! output stream and the bitmap engine's bytes; ignored unless `capacity` is page-aligned
+    //! \param engine selects how bytes waiting to be assembled are stored
+    StreamReassembler(const size_t capacity, const bool double_mapped = false, const Engine engine = Engine::Interval);
  
     //! \brief Receive a substring and write any newly contiguous bytes into the stream.
     //!
@@ -36,6 +66,12 @@ class StreamReassembler {
     //! \param index indicates the index (place in sequence) of the first byte in `data`
     //! \param eof the last byte of `data` will be the last byte in the entire stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
+
+    //! \brief Receive a substring held in a refcounted Buffer
+    //! \details With the interval engine, pending and in-order bytes are kept as slices of `data`
+    //! all the way to the output stream. A slice much smaller than the storage of `data` is copied
+    //! instead (see ByteStream::MAX_PIN_RATIO), so a small segment never pins a large buffer.
+    void push_substring(const Buffer &data, const uint64_t index, const bool eof);
  
     //! \name Access the reassembled byte stream
     //!@{
@@ -49,6 +85,14 @@ class StreamReassembler {
     //! should only be counted once for the purpose of this function.
     size_t unassembled_bytes() const;
  
+    //! \brief The ranges of stream indices [first, last) held but not yet reassembled, in order
+    //! \details Adjacent pieces are merged, so consecutive ranges are separated by a hole.
+    std::vector<std::pair<uint64_t, uint64_t>> pending_ranges() const;
+
+    //! \brief The bytes of storage pinned by the substrings not yet reassembled, summed over the slices
+    //! \details Always 0 with the bitmap engine, which copies bytes into storage of its own.
+    size_t pending_storage() const;
+
     //! \brief Is the internal state empty (other than the output stream)?
     //! \returns `true` if no substrings are waiting to be assembled
     bool empty() const;
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <limits>
+#include <stdexcept>
 
 // Dummy implementation of a TCP connection
 
@@ -19,10 +20,34 @@ size_t TCPConnection::bytes_in_flight() const { return _sender.bytes_in_flight()
 
 size_t TCPConnection::unassembled_bytes() const { return _receiver.unassembled_bytes(); }
 
-size_t TCPConnection::time_since_last_segment_received() const { return _time_since_last_segment_received; }
+size_t TCPConnection::time_since_last_segment_received() const {
+    return _sender.time_ms() - _last_segment_received_ms;
+}
 
 void TCPConnection::segment_received(const TCPSegment &seg) {
-    _time_since_last_segment_received = 0;
+    _last_segment_received_ms = _sender.time_ms();
+    if (_state == TCPState::State::TIME_WAIT) {
+        _arm_linger(); // the peer may still be retransmitting its FIN
+    }
+
+    // header prediction: the common cases of an established connection skip the rest
+    if (_header_predicted(seg)) {
+        ++_prediction_counters.fast_path;
+        if (seg.payload().size() == 0) {
+            // a pure ACK of new data: only the sender has anything to do (and the receiver takes its timestamp)
+            if (_timestamps()) {
+                _receiver.segment_received(seg);
+            }
+            _sender.ack_received(seg.header().ackno, _peer_window(seg.header()), 0, {}, _ts_echo(seg.header()));
+            _add_ackno_and_window_and_send();
+        } else {
+            // in-sequence data that acknowledges nothing new: only the receiver has anything to do
+            _receiver.segment_received(seg);
+            _acknowledge(seg, true, true, false);
+        }
+        return;
+    }
+    ++_prediction_counters.slow_path;
 
     const auto& header =  seg.header();
 
@@ -32,10 +57,43 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
         return;
     }
 
+    // PAWS: an old duplicate is dropped, but its data is acknowledged, so a confused peer can resynchronize
+    if (_receiver.stale(seg)) {
+        if (seg.length_in_sequence_space() > 0) {
+            _sender.send_empty_segment();
+            _add_ackno_and_window_and_send();
+        }
+        return;
+    }
+
+    // with accurate ECE, an ACK held back for earlier segments must echo their marks: it goes now,
+    // before a segment whose mark differs
+    if (_accurate_ece() && _ecn() && _ack_pending_segments > 0 && seg.payload().size() > 0 &&
+        (seg.ecn() == IPv4Header::ECN::CE) != _receiver.last_ce()) {
+        _sender.send_empty_segment();
+        _add_ackno_and_window_and_send();
+    }
+
     // give the segment to the receiver to extract data
     // while receiving FIN, end the input stream in reassembler
+    const bool in_order = _receiver.ackno().has_value() && header.seqno == _receiver.ackno().value();
+    const bool had_hole = _receiver.unassembled_bytes() > 0;
     _receiver.segment_received(seg);
 
+    // the peer's SYN settles whether SACK (and so RACK-TLP) and ECN are used
+    if (header.syn) {
+        _sender.set_sack_permitted(_cfg.sack && _receiver.sack_permitted());
+        _sender.set_ecn(_ecn());
+    }
+
+    // the peer's SYN settles the segment size: the smaller of the two offers (without its offer, ours)
+    if (header.syn && _receiver.mss().value_or(0) > 0) {
+        const size_t mss = min<size_t>(_mss_offer(), _receiver.mss().value());
+        if (mss != _sender.mss()) {
+            _sender.set_mss(mss);
+        }
+    }
+
     // must be acked when the segment has payload or SYN or FIN
     bool need_empty_ack = seg.length_in_sequence_space() > 0;
 
@@ -43,33 +101,30 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
     if (header.ack) {
         // ack SYN, update ackno and window size, and fill the window 
         // also handle ACK in the third handshake, with payload filled here and ACK added below
-        _sender.ack_received(header.ackno, header.win);
+        const bool ece = header.ece && !header.syn; // on a SYN, ECE is the ECN setup, not an echo
+        _sender.ack_received(header.ackno,
+                             _peer_window(header),
+                             seg.length_in_sequence_space(),
+                             header.sack_blocks,
+                             _ts_echo(header),
+                             ece);
         // no need to send empty ack if we can send ack with segments (piggybacking)
-        if (need_empty_ack && !_segments_out.empty())
+        // only the sender's new segments count: those in _segments_out, still waiting for the owner,
+        // carry an older ackno, and each out-of-order segment needs an ACK of its own (a duplicate)
+        if (need_empty_ack && !_sender.segments_out().empty())
             need_empty_ack = false;
     }
 
     // while receiving SYN at LISTEN state，the connection changes its state to SYN RECEIVED
-    if (TCPState::state_summary(_receiver) == TCPReceiverStateSummary::SYN_RECV &&
-        TCPState::state_summary(_sender) == TCPSenderStateSummary::CLOSED) {
+    if (_state == TCPState::State::LISTEN && _receiver.ackno().has_value() && !_receiver.stream_out().input_ended()) {
         // send back SYN ACK
         connect();
         return;
     }
 
-    // clean shutdown (Passive close)
-    // check if the passive CLOSE is initiated
-    if (TCPState::state_summary(_receiver) == TCPReceiverStateSummary::FIN_RECV && // FIN received; inbound stream ended (#1)
-        TCPState::state_summary(_sender) == TCPSenderStateSummary::SYN_ACKED) { // stream ongoing (outbound not reaching eof)
-        _linger_after_streams_finish = false;
-    }
-
-    // if everything for passive CLOSE is satisfied, close the connection
-    if (!_linger_after_streams_finish && 
-        TCPState::state_summary(_receiver) == TCPReceiverStateSummary::FIN_RECV && // input ended (#1)
-        TCPState::state_summary(_sender) == TCPSenderStateSummary::FIN_ACKED) { // outbound stream ended and acked (#2 #3)
-        _is_active = false;
-        _linger_after_streams_finish = false;
+    // a FIN may start a passive close (CLOSE_WAIT), and the ACK of ours end it (CLOSED)
+    _update_state();
+    if (!active()) {
         return;
     }
     
@@ -80,6 +135,24 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
         need_empty_ack = true;
     }
 
+    _acknowledge(seg, need_empty_ack, in_order, had_hole);
+}
+
+void TCPConnection::_acknowledge(const TCPSegment &seg,
+                                 bool need_empty_ack,
+                                 const bool in_order,
+                                 const bool had_hole) {
+    // with delayed ACKs, a pure ACK waits for a second segment's worth of data or the timer
+    if (need_empty_ack && _cfg.delayed_ack && _may_delay_ack(seg, in_order, had_hole)) {
+        if (_ack_pending_segments++ == 0) {
+            _sender.timers().arm(TCPTimers::Kind::DelayedAck, _cfg.delayed_ack_timeout);
+        }
+        _ack_pending_bytes += seg.payload().size();
+        need_empty_ack = _ack_pending_bytes >= 2 * _sender.mss();
+    } else if (need_empty_ack) {
+        ++_ack_pending_segments; // acknowledged right below
+    }
+
     // send empty ACK when 1. can't send ACK with the segment, 2. keep-alive mechanism
     if (need_empty_ack) {
         _sender.send_empty_segment();
@@ -89,7 +162,53 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
     _add_ackno_and_window_and_send();
 }
 
-bool TCPConnection::active() const { return _is_active; }
+//! \details Van Jacobson's header prediction: on an established connection, most segments are either
+//! a pure ACK of new data (at the sender) or the next in-sequence data acknowledging nothing new (at
+//! the receiver). Anything else takes the slow path: flags other than ACK and PSH, SACK blocks, a
+//! stale timestamp, a changed window, congestion marks, recovery, a hole in the receiver, or (as the
+//! ACK would release it) data held back by pacing.
+bool TCPConnection::_header_predicted(const TCPSegment &seg) const {
+    using State = TCPState::State;
+    const auto &header = seg.header();
+    const bool pure_ack = seg.payload().size() == 0;
+    // a pure ACK while our FIN is unsent, so that it cannot close the connection; data while the
+    // peer's FIN is yet to come (in-sequence data cannot follow it)
+    if (pure_ack ? _state != State::ESTABLISHED && _state != State::CLOSE_WAIT
+                 : _state != State::ESTABLISHED && _state != State::FIN_WAIT_2) {
+        return false;
+    }
+    if (!header.ack || header.syn || header.fin || header.rst || header.urg || header.ece || header.cwr ||
+        !header.sack_blocks.empty() || seg.ecn() == IPv4Header::ECN::CE || _receiver.last_ce() ||
+        header.seqno != _receiver.ackno().value() || _receiver.stale(seg)) {
+        return false;
+    }
+
+    const auto unacked = _sender.next_seqno() - header.ackno; // what the ACK leaves outstanding
+    if (pure_ack) {
+        return unacked >= 0 && static_cast<size_t>(unacked) < _sender.bytes_in_flight() &&
+               !_sender.in_fast_recovery();
+    }
+    return unacked == 0 && _sender.bytes_in_flight() == 0 && _peer_window(header) == _sender.window_size() &&
+           _receiver.unassembled_bytes() == 0 && seg.payload().size() <= _receiver.window_size() &&
+           !_sender.ms_until_release().has_value();
+}
+
+size_t TCPConnection::_peer_window(const TCPHeader &header) const {
+    size_t window = header.win;
+    if (!header.syn && _window_scaling()) { // the window on a SYN is never scaled
+        window <<= _receiver.window_scale().value();
+    }
+    return window;
+}
+
+optional<uint32_t> TCPConnection::_ts_echo(const TCPHeader &header) const {
+    if (_timestamps() && header.timestamps.has_value()) {
+        return header.timestamps.value().echo;
+    }
+    return nullopt;
+}
+
+bool TCPConnection::active() const { return _state != TCPState::State::CLOSED && _state != TCPState::State::RESET; }
 
 // applications write data to the outbound byte stream and send it over TCP
 size_t TCPConnection::write(const string &data) {
@@ -99,33 +218,166 @@ size_t TCPConnection::write(const string &data) {
     return n;
 }
 
+size_t TCPConnection::write(Buffer data) {
+    auto n = _sender.stream_in().write(move(data));
+    _sender.fill_window();
+    _add_ackno_and_window_and_send();
+    return n;
+}
+
+size_t TCPConnection::write(const BufferList &data) {
+    auto n = _sender.stream_in().write(data);
+    _sender.fill_window();
+    _add_ackno_and_window_and_send();
+    return n;
+}
+
 //! \param[in] ms_since_last_tick number of milliseconds since the last call to this method
 void TCPConnection::tick(const size_t ms_since_last_tick) {
-    _time_since_last_segment_received += ms_since_last_tick;
+    _sender.timers().advance(ms_since_last_tick, [&](const TCPTimers::Kind timer) { timer_expired(timer); });
 
-    // call sender's tick to handle retransmission and backoff logic
-    _sender.tick(ms_since_last_tick);
+    // the application may have read enough to announce a larger window
+    inbound_stream_read();
+}
 
-    // RST if too many retransmissions
-    if (_sender.consecutive_retransmissions() > TCPConfig::MAX_RETX_ATTEMPTS) {
-        // clear up everything and close the connection
-        while (!_sender.segments_out().empty()) _sender.segments_out().pop();
-        _set_rst_state(true);
+void TCPConnection::timer_expired(const TCPTimers::Kind timer) {
+    if (!active() || !_sender.timers().fired(timer)) {
         return;
     }
+    switch (timer) {
+        case TCPTimers::Kind::DelayedAck:
+            if (_ack_pending_segments > 0) {
+                ++_ack_counters.delayed_ack_timeouts;
+                _sender.send_empty_segment();
+            }
+            break;
+        case TCPTimers::Kind::Linger:
+            // Clean shutdown (Active close)
+            if (_state == TCPState::State::TIME_WAIT) {
+                _state = TCPState::State::CLOSED;
+                _sender.timers().cancel_all();
+            }
+            return;
+        default:
+            // the sender handles retransmission and backoff
+            _sender.timer_expired(timer);
+
+            // RST if too many retransmissions
+            if (_sender.consecutive_retransmissions() > TCPConfig::MAX_RETX_ATTEMPTS) {
+                // clear up everything and close the connection
+                while (!_sender.segments_out().empty()) _sender.segments_out().pop();
+                _set_rst_state(true);
+                return;
+            }
+    }
 
     // retranmission
     _add_ackno_and_window_and_send();
+}
 
-    // Clean shutdown (Active close)
-    if (_linger_after_streams_finish && // not passive close case
-        TCPState::state_summary(_receiver) == TCPReceiverStateSummary::FIN_RECV && // inbound stream has ended (#1)
-        TCPState::state_summary(_sender) == TCPSenderStateSummary::FIN_ACKED && // outbound stream ended and acked (#2 #3)
-        _time_since_last_segment_received >= 10 * _cfg.rt_timeout) {
-        _is_active = false;
+void TCPConnection::inbound_stream_read() {
+    if (active() && _ack_pending_segments > 0 && _window_opened()) {
+        _sender.send_empty_segment();
+        _add_ackno_and_window_and_send();
     }
 }
 
+void TCPConnection::_arm_linger() {
+    const uint64_t linger = 10 * _cfg.rt_timeout;
+    _sender.timers().arm(TCPTimers::Kind::Linger, linger - min<uint64_t>(time_since_last_segment_received(), linger));
+}
+
+void TCPConnection::_update_state() {
+    using State = TCPState::State;
+    const auto fin_sent = [&] {
+        return _sender.stream_in().eof() && _sender.next_seqno_absolute() == _sender.stream_in().bytes_written() + 2;
+    };
+    const auto fin_acked = [&] { return fin_sent() && _sender.bytes_in_flight() == 0; };
+    const auto fin_received = [&] { return _receiver.stream_out().input_ended(); };
+
+    // one call may take several transitions (an ACK of our FIN that carries the peer's, say)
+    const State before = _state;
+    State from;
+    do {
+        from = _state;
+        switch (_state) {
+            case State::LISTEN:
+                if (_sender.next_seqno_absolute() > 0) {
+                    _state = _receiver.ackno().has_value() ? State::SYN_RCVD : State::SYN_SENT;
+                }
+                break;
+            case State::SYN_SENT:
+                if (_receiver.ackno().has_value()) {
+                    _state = State::SYN_RCVD;
+                }
+                break;
+            case State::SYN_RCVD:
+                if (_sender.next_seqno_absolute() > _sender.bytes_in_flight()) {
+                    _state = State::ESTABLISHED;
+                }
+                break;
+            case State::ESTABLISHED:
+                if (fin_sent()) {
+                    _state = State::FIN_WAIT_1;
+                } else if (fin_received()) {
+                    _state = State::CLOSE_WAIT;
+                }
+                break;
+            case State::FIN_WAIT_1:
+                if (fin_acked()) {
+                    _state = State::FIN_WAIT_2;
+                } else if (fin_received()) {
+                    _state = State::CLOSING;
+                }
+                break;
+            case State::FIN_WAIT_2:
+                if (fin_received()) {
+                    _state = State::TIME_WAIT;
+                }
+                break;
+            case State::CLOSING:
+                if (fin_acked()) {
+                    _state = State::TIME_WAIT;
+                }
+                break;
+            case State::CLOSE_WAIT:
+                if (fin_sent()) {
+                    _state = State::LAST_ACK;
+                }
+                break;
+            case State::LAST_ACK:
+                if (fin_acked()) {
+                    _state = State::CLOSED;
+                }
+                break;
+            case State::TIME_WAIT:  // left when the linger timer goes off
+            case State::CLOSED:
+            case State::RESET:
+                break;
+        }
+    } while (_state != from);
+
+    if (_state != before && _state == State::TIME_WAIT) {
+        _arm_linger();
+    } else if (_state != before && _state == State::CLOSED) {
+        _sender.timers().cancel_all();
+    }
+
+#ifndef NDEBUG
+    // whether to linger is the one thing the summaries can't tell: it is settled by the path taken
+    const bool linger = _state != State::CLOSE_WAIT && _state != State::LAST_ACK;
+    const TCPState derived{_sender, _receiver, active(), linger};
+    if (derived != TCPState{_state}) {
+        throw runtime_error("TCPConnection is in state " + TCPState{_state}.name() +
+                            ", but its sender and receiver in " + derived.name());
+    }
+#endif
+}
+
+optional<uint64_t> TCPConnection::ms_until_timeout() const {
+    return active() ? _sender.timers().ms_until_next() : nullopt;
+}
+
 // close the outbound byte stream; send FIN
 void TCPConnection::end_input_stream() { 
     // stop getting more data from the application
@@ -135,6 +387,42 @@ void TCPConnection::end_input_stream() {
     _add_ackno_and_window_and_send();
 }
 
+void TCPConnection::set_nodelay(const bool nodelay) {
+    if (nodelay == _sender.nodelay()) return;
+    _sender.set_nodelay(nodelay);
+    _flush_held_data();
+}
+
+void TCPConnection::set_corked(const bool corked) {
+    if (corked == _sender.corked()) return;
+    _sender.set_corked(corked);
+    _flush_held_data();
+}
+
+// send what coalescing was holding back, but don't start a connection (fill_window would send a SYN)
+void TCPConnection::_flush_held_data() {
+    if (_sender.next_seqno_absolute() == 0) return;
+    _sender.fill_window();
+    _add_ackno_and_window_and_send();
+}
+
+bool TCPConnection::_may_delay_ack(const TCPSegment &seg, const bool in_order, const bool had_hole) const {
+    return in_order && !had_hole && _receiver.unassembled_bytes() == 0 && !seg.header().syn && !seg.header().fin &&
+           !_window_opened();
+}
+
+bool TCPConnection::_window_opened() const {
+    return _receiver.window_size() >= _last_advertised_window + 2 * _sender.mss();
+}
+
+uint8_t TCPConnection::_window_shift_for(const size_t capacity) {
+    uint8_t shift = 0;
+    while (shift < TCPHeader::MAX_WINDOW_SCALE && (capacity >> shift) > numeric_limits<uint16_t>::max()) {
+        ++shift;
+    }
+    return shift;
+}
+
 // initiate a connection; handles SYN and SYN ACK
 void TCPConnection::connect() {
     // SYN is sent in fill_window(), with no payload as the initial window size is 1
@@ -169,8 +457,8 @@ void TCPConnection::_set_rst_state(const bool send_rst) {
     // close itself (unclean shutdown)
     _sender.stream_in().set_error();
     _receiver.stream_out().set_error();
-    _linger_after_streams_finish = false;
-    _is_active = false;
+    _state = TCPState::State::RESET;
+    _sender.timers().cancel_all();
 }
 
 void TCPConnection::_add_ackno_and_window_and_send() {
@@ -181,9 +469,49 @@ void TCPConnection::_add_ackno_and_window_and_send() {
         if (_receiver.ackno().has_value()) { // read the ackno from the receiver; no need to ack if no ackno (the first SYN)
             seg.header().ack = true;
             seg.header().ackno = _receiver.ackno().value();
+            _receiver.ack_sent();
+        }
+        // read the window size from the receiver, scaled down if both SYNs offered scaling (but not on a SYN),
+        // with the maximum value of uint16_t
+        const auto shift = _window_scaling() && !seg.header().syn ? _window_shift : 0;
+        seg.header().win = min(static_cast<size_t>(numeric_limits<uint16_t>::max()), _receiver.window_size() >> shift);
+        if (seg.header().syn) {
+            seg.header().mss = min<size_t>(_mss_offer(), numeric_limits<uint16_t>::max());
+        }
+        // offer scaling on our SYN; on a SYN ACK, only if the peer's SYN offered it
+        if (seg.header().syn && _cfg.window_scaling &&
+            (!_receiver.ackno().has_value() || _receiver.window_scale().has_value())) {
+            seg.header().window_scale = _window_shift;
+        }
+        // timestamps likewise, but then on every segment
+        if (_timestamps() || (seg.header().syn && _cfg.timestamps && !_receiver.ackno().has_value())) {
+            const auto now = static_cast<uint32_t>(_sender.time_ms());
+            seg.header().timestamps = TCPTimestamps{now, _receiver.ts_recent().value_or(0)};
+        }
+        // ECN: a SYN asks for it with ECE and CWR, a SYN/ACK accepts with ECE alone; then ACKs echo marks
+        if (seg.header().syn && _ecn_offer()) {
+            const bool syn_ack = _receiver.ackno().has_value();
+            seg.header().ece = !syn_ack || _receiver.ecn_setup();
+            seg.header().cwr = !syn_ack;
+        } else if (seg.header().ack && _ecn()) {
+            seg.header().ece = _ece();
+        }
+        // SACK only if both SYNs offered it
+        if (_cfg.sack && _receiver.sack_permitted()) {
+            seg.header().sack_blocks = _receiver.sack_blocks();
+        }
+        seg.header().doff = (TCPHeader::LENGTH + seg.header().options_length()) / 4;
+
+        // this ACK covers everything received so far; as a pure ACK, it stands in for one of the segments
+        if (seg.header().ack) {
+            const size_t pure_ack = seg.length_in_sequence_space() == 0 && !seg.header().rst ? 1 : 0;
+            _ack_counters.pure_acks_sent += pure_ack;
+            _ack_counters.pure_acks_suppressed += _ack_pending_segments - min(_ack_pending_segments, pure_ack);
+            _ack_pending_segments = _ack_pending_bytes = 0;
+            _sender.timers().cancel(TCPTimers::Kind::DelayedAck);
+            _last_advertised_window = size_t{seg.header().win} << shift;
         }
-        // read the window size from the receiver, with the maximum value of uint16_t
-        seg.header().win = min(static_cast<size_t>(numeric_limits<uint16_t>::max()), _receiver.window_size());
         _segments_out.emplace(std::move(seg));
     }
+    _update_state();
 }
\ No newline at end of file
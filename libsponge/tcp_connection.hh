@@ -6,26 +6,111 @@
 #include "tcp_sender.hh"
 #include "tcp_state.hh"
 
+//! \brief How many ACKs a TCPConnection sent on their own, and how many it saved by delaying them
+struct AckCounters {
+    uint64_t pure_acks_sent = 0;        //!< Segments sent that carried nothing but an ACK (and window)
+    uint64_t pure_acks_suppressed = 0;  //!< Received segments whose ACK was coalesced with a later one or piggybacked
+    uint64_t delayed_ack_timeouts = 0;  //!< Delayed ACKs sent because the timer expired
+};
+
+//! \brief How many received segments took the header-prediction fast path, and how many the full one
+struct PredictionCounters {
+    uint64_t fast_path = 0;  //!< Pure ACKs of new data, and in-sequence data acknowledging nothing new
+    uint64_t slow_path = 0;  //!< Everything else
+};
+
 //! \brief A complete endpoint of a TCP connection
 class TCPConnection {
   private:
     TCPConfig _cfg;
-    TCPReceiver _receiver{_cfg.recv_capacity};
-    TCPSender _sender{_cfg.send_capacity, _cfg.rt_timeout, _cfg.fixed_isn};
+    TCPReceiver _receiver{_cfg.recv_capacity, _cfg.double_mapped_buffers, _cfg.reassembler_engine};
+    TCPSender _sender{_cfg};
 
     //! outbound queue of segments that the TCPConnection wants sent
     std::queue<TCPSegment> _segments_out{};
 
-    //! Should the TCPConnection stay active (and keep ACKing)
-    //! for 10 * _cfg.rt_timeout milliseconds after both streams have ended,
-    //! in case the remote TCPConnection doesn't know we've received its whole stream?
-    bool _linger_after_streams_finish{true};
+    //! \brief Where the connection is in the [TCP](\ref rfc::rfc793) state machine
+    //! \details Kept up to date by _update_state() rather than derived from the sender and receiver on
+    //! each use. A connection that sees the peer's FIN before its own stream has ended closes passively
+    //! (CLOSE_WAIT, LAST_ACK); one that sends its FIN first lingers in TIME_WAIT for 10 * _cfg.rt_timeout
+    //! milliseconds, in case the peer doesn't know we've received its whole stream.
+    TCPState::State _state{TCPState::State::LISTEN};
+
+    //! When the last segment was received, by the sender's clock
+    uint64_t _last_segment_received_ms = _sender.time_ms();
+
+    //! \name Delayed ACKs (RFC 1122 4.2.3.2, RFC 5681 4.2)
+    //!@{
+    size_t _ack_pending_segments = 0;     //!< Received segments not yet acknowledged
+    size_t _ack_pending_bytes = 0;        //!< Their payload
+    size_t _last_advertised_window = 0;  //!< The window sent with the last ACK
+    AckCounters _ack_counters{};
+    //!@}
+
+    PredictionCounters _prediction_counters{};
+
+    //! \brief Whether `seg` is one of the two cases header prediction handles on an established
+    //! connection: a pure ACK of new data, or in-sequence data that acknowledges nothing new
+    bool _header_predicted(const TCPSegment &seg) const;
+
+    //! The peer's window, in bytes, from the `win` of `header` (scaled, if scaling is in effect)
+    size_t _peer_window(const TCPHeader &header) const;
+
+    //! The TSecr of `header`, if timestamps are in use
+    std::optional<uint32_t> _ts_echo(const TCPHeader &header) const;
+
+    //! \brief Acknowledge a received segment, at once or (with delayed ACKs) later, and send what is queued
+    //! \param need_empty_ack is whether `seg` needs an ACK that no queued segment can carry
+    void _acknowledge(const TCPSegment &seg, bool need_empty_ack, const bool in_order, const bool had_hole);
+
+    //! The MSS offered on our SYN: the largest payload we take
+    size_t _mss_offer() const { return _cfg.mss > 0 ? _cfg.mss : TCPConfig::MAX_PAYLOAD_SIZE; }
+
+    //! \name Window scaling (RFC 7323)
+    //!@{
+    uint8_t _window_shift = _window_shift_for(_cfg.recv_capacity);  //!< Shift offered on our SYN
+
+    //! The smallest shift that lets a 16-bit `win` describe `capacity` bytes
+    static uint8_t _window_shift_for(const size_t capacity);
+
+    //! Both SYNs offered the option, so `win` is scaled in both directions (except on SYNs)
+    bool _window_scaling() const { return _cfg.window_scaling && _receiver.window_scale().has_value(); }
+    //!@}
+
+    //! Both SYNs carried the timestamps option (RFC 7323), so every segment does
+    bool _timestamps() const { return _cfg.timestamps && _receiver.ts_recent().has_value(); }
 
-    //! Number of milliseconds since the last segment was received
-    size_t _time_since_last_segment_received = 0;
+    //! \name Explicit congestion notification (RFC 3168)
+    //!@{
+    //! Offer ECN on our SYN: if configured, and always for DCTCP, which depends on it
+    bool _ecn_offer() const {
+        return _cfg.ecn || _cfg.congestion_control == CongestionController::Algorithm::DCTCP;
+    }
+
+    //! Both SYNs set up ECN
+    bool _ecn() const { return _ecn_offer() && _receiver.ecn_setup(); }
+
+    //! The receiver echoes each segment's mark, for DCTCP, rather than latching ECE until CWR
+    bool _accurate_ece() const { return _cfg.congestion_control == CongestionController::Algorithm::DCTCP; }
+
+    //! Whether our ACKs carry ECE
+    bool _ece() const { return _accurate_ece() ? _receiver.last_ce() : _receiver.ece_latched(); }
+    //!@}
 
-    //! Is the connection still alive in any way?
-    bool _is_active = true;
+    //! \brief Whether the ACK for `seg` may wait
+    //! \details Not for a SYN or FIN, nor for a segment that is out of order, fills (part of) a hole,
+    //! or arrives while the receiver's window has opened since it was last advertised.
+    bool _may_delay_ack(const TCPSegment &seg, const bool in_order, const bool had_hole) const;
+
+    //! The receiver's window has grown by at least two segments since it was last advertised
+    bool _window_opened() const;
+
+    //! \brief Take the transitions the sender and receiver have made since the last call
+    //! \details In a debug build, checks the result against TCPState's summaries of the two.
+    void _update_state();
+
+    //! Arm the linger timer to go off 10 * _cfg.rt_timeout after the last segment was received
+    void _arm_linger();
 
     //! Send a RST segment and close the connection
     void _set_rst_state(const bool send_rst);
@@ -33,6 +118,9 @@ class TCPConnection {
     //! Add an ACK and window size to the segments to send
     void _add_ackno_and_window_and_send();
 
+    //! Send what Nagle's algorithm or cork may have been holding back
+    void _flush_held_data();
+
   public:
     //! \name "Input" interface for the writer
     //!@{
@@ -44,11 +132,26 @@ class TCPConnection {
     //! \returns the number of bytes from `data` that were actually written.
     size_t write(const std::string &data);
 
+    //! \brief Write a refcounted Buffer to the outbound byte stream without copying it
+    //! \details Outgoing segments carry slices of `data`, which stays alive until they are acknowledged.
+    //! \returns the number of bytes from `data` that were actually written.
+    size_t write(Buffer data);
+
+    //! \brief Write a BufferList to the outbound byte stream without copying it (see write(Buffer))
+    //! \returns the number of bytes from `data` that were actually written.
+    size_t write(const BufferList &data);
+
     //! \returns the number of `bytes` that can be written right now.
     size_t remaining_outbound_capacity() const;
 
     //! \brief Shut down the outbound byte stream (still allows reading incoming data)
     void end_input_stream();
+
+    //! \brief Send small writes at once (true), or coalesce them with Nagle's algorithm (see TCPConfig::nodelay)
+    void set_nodelay(const bool nodelay);
+
+    //! \brief Hold partial segments until uncorked; uncorking sends what was held
+    void set_corked(const bool corked);
     //!@}
 
     //! \name "Output" interface for the reader
@@ -67,8 +170,18 @@ class TCPConnection {
     size_t unassembled_bytes() const;
     //! \brief Number of milliseconds since the last segment was received
     size_t time_since_last_segment_received() const;
-    //!< \brief summarize the state of the sender, receiver, and the connection
-    TCPState state() const { return {_sender, _receiver, active(), _linger_after_streams_finish}; };
+    //! \brief the sender's round-trip time estimates
+    const RTTEstimator &rtt_estimator() const { return _sender.rtt_estimator(); }
+    //! \brief the retransmission timeout currently armed, in milliseconds
+    uint32_t rto_ms() const { return _sender.rto_ms(); }
+    //! \brief times cwnd was reduced for ECN-Echo
+    uint64_t ecn_reductions() const { return _sender.ecn_reductions(); }
+    //! \brief ACKs sent and saved
+    const AckCounters &ack_counters() const { return _ack_counters; }
+    //! \brief Segments received on the header-prediction fast path and on the slow path
+    const PredictionCounters &prediction_counters() const { return _prediction_counters; }
+    //! \brief the state of the connection
+    TCPState::State state() const { return _state; }
     //!@}
 
     //! \name Methods for the owner or operating system to call
@@ -77,9 +190,27 @@ class TCPConnection {
     //! Called when a new segment has been received from the network
     void segment_received(const TCPSegment &seg);
 
-    //! Called periodically when time elapses
+    //! \brief Called periodically when time elapses, to advance the connection's own wheel
+    //! \details Throws for a connection on a shared wheel: its host advances the wheel instead.
     void tick(const size_t ms_since_last_tick);
 
+    //! \brief Called by the host when timer `timer` of this connection goes off on the shared wheel
+    void timer_expired(const TCPTimers::Kind timer);
+
+    //! \brief Called after the application reads from the inbound stream: if that opened the window
+    //! by two segments while an ACK is being delayed, the ACK goes now (RFC 1122 4.2.3.3)
+    //! \details tick() does this too.
+    void inbound_stream_read();
+
+    //! \brief How soon pacing releases the segments it holds back, in milliseconds
+    //! \returns empty if pacing is not holding anything back
+    std::optional<uint64_t> ms_until_release() const { return _sender.ms_until_release(); }
+
+    //! \brief How soon the earliest timer goes off, in milliseconds: the sender's (see
+    //! TCPSender::ms_until_timeout), the delayed ACK's, or the end of the linger
+    //! \returns empty if no timer is armed
+    std::optional<uint64_t> ms_until_timeout() const;
+
     //! \brief TCPSegments that the TCPConnection has enqueued for transmission.
     //! \note The owner or operating system will dequeue these and
     //! put each one into the payload of a lower-layer datagram (usually Internet datagrams (IP),
@@ -92,9 +223,16 @@ class TCPConnection {
     bool active() const;
     //!@}
 
-    //! Construct a new connection from a configuration
+    //! Construct a new connection from a configuration, with a timing wheel of its own that tick() advances
     explicit TCPConnection(const TCPConfig &cfg) : _cfg{cfg} {}
 
+    //! \brief Construct a new connection whose timers are on `wheel`, which the host shares among its
+    //! connections and advances
+    //! \details The host hands each timer that goes off to timer_expired() of the connection whose
+    //! `endpoint` is TCPTimers::endpoint_of() the timer's key.
+    TCPConnection(const TCPConfig &cfg, TimingWheel &wheel, const uint64_t endpoint)
+        : _cfg{cfg}, _sender{_cfg, wheel, endpoint} {}
+
     //! \name construction and destruction
     //! moving is allowed; copying is disallowed; default construction not possible
 
@@ -17,6 +17,7 @@ std::string to_string(const EthernetAddress address);
 //! \brief Ethernet frame header
 struct EthernetHeader {
     static constexpr size_t LENGTH = 14;          //!< Ethernet header length in bytes
+    static constexpr size_t MTU = 1500;           //!< Largest payload of a standard Ethernet frame
     static constexpr uint16_t TYPE_IPv4 = 0x800;  //!< Type number for [IPv4](\ref rfc::rfc791)
     static constexpr uint16_t TYPE_ARP = 0x806;   //!< Type number for [ARP](\ref rfc::rfc826)
 
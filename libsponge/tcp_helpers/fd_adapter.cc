@@ -1,5 +1,7 @@
 #include "fd_adapter.hh"
 
+#include "ipv4_header.hh"
+
 #include <iostream>
 #include <stdexcept>
 #include <utility>
@@ -46,11 +48,37 @@ optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
 }
 
 //! Serialize a TCP segment and send it as the payload of a UDP datagram.
+//! A super-segment (see TCPConfig::tso_size) is first cut into wire segments, one per datagram.
 //! \param[in] seg is the TCP segment to write
 void TCPOverUDPSocketAdapter::write(TCPSegment &seg) {
     seg.header().sport = config().source.port();
     seg.header().dport = config().destination.port();
-    _sock.sendto(config().destination, seg.serialize(0));
+    if (not seg.needs_split()) {
+        _sock.sendto(config().destination, seg.serialize(0));
+        return;
+    }
+    for (const auto &piece : seg.split(seg.wire_mss())) {
+        _sock.sendto(config().destination, piece.serialize(0));
+    }
+}
+
+//! \details Probes the kernel's path MTU with a UDP socket connected to the destination. A listening
+//! adapter has no destination yet (nor does one whose probe fails), and assumes an Ethernet-sized path.
+//! Room is left for the largest TCP header, so that no segment needs fragmenting whatever its options.
+size_t TCPOverUDPSocketAdapter::mss_hint() {
+    constexpr size_t UDP_HEADER_LENGTH = 8;
+    constexpr size_t MAX_IPV4_LENGTH = 65535;
+    size_t mtu = 1500;
+    if (not listening() and config().destination.port() != 0) {
+        try {
+            UDPSocket probe;
+            probe.connect(config().destination);
+            mtu = min(probe.path_mtu(), MAX_IPV4_LENGTH);
+        } catch (const exception &e) {
+            cerr << "DEBUG: path MTU probe failed (" << e.what() << "), assuming " << mtu << " bytes\n";
+        }
+    }
+    return mtu - IPv4Header::LENGTH - UDP_HEADER_LENGTH - TCPHeader::MAX_LENGTH;
 }
 
 //! Specialize LossyFdAdapter to TCPOverUDPSocketAdapter
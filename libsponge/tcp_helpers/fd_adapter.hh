@@ -40,6 +40,10 @@ class FdAdapterBase {
 
     //! Called periodically when time elapses
     void tick(const size_t) {}
+
+    //! \brief The largest TCP payload that fits in one datagram of the adapter's link
+    //! \details TCPSpongeSocket uses it when TCPConfig::mss is left at 0
+    size_t mss_hint() { return TCPConfig::MAX_PAYLOAD_SIZE; }
 };
 
 //! \brief A FD adaptor that reads and writes TCP segments in UDP payloads
@@ -57,6 +61,9 @@ class TCPOverUDPSocketAdapter : public FdAdapterBase {
     //! Writes a TCP segment into a UDP payload
     void write(TCPSegment &seg);
 
+    //! The largest TCP payload that fits in a UDP datagram on the path to the destination
+    size_t mss_hint();
+
     //! Access the underlying UDP socket
     operator UDPSocket &() { return _sock; }
 
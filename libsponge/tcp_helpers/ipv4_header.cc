@@ -153,6 +153,7 @@ std::string IPv4Header::summary() const {
     ss << hex << boolalpha << "IPv" << +ver << ", "
        << "len=" << +len << ", "
        << "protocol=" << +proto << ", " << (ttl >= 10 ? "" : "ttl=" + ::to_string(ttl) + ", ")
+       << (ecn() == ECN::CE ? "ecn=CE, " : "")
        << "src=" << inet_ntoa({htobe32(src)}) << ", "
        << "dst=" << inet_ntoa({htobe32(dst)});
     return ss.str();
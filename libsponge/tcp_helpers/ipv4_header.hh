@@ -10,6 +10,14 @@ struct IPv4Header {
     static constexpr uint8_t DEFAULT_TTL = 128;  //!< A reasonable default TTL value
     static constexpr uint8_t PROTO_TCP = 6;      //!< Protocol number for [tcp](\ref rfc::rfc793)
 
+    //! \brief ECN codepoints (RFC 3168): the low two bits of `tos`
+    enum class ECN : uint8_t {
+        NotECT = 0b00,  //!< The sender's transport does not react to marks
+        ECT1 = 0b01,    //!< ECN-capable transport
+        ECT0 = 0b10,    //!< ECN-capable transport (the codepoint TCP sends)
+        CE = 0b11       //!< Congestion experienced: marked by a router instead of being dropped
+    };
+
     //! \struct IPv4Header
     //! ~~~{.txt}
     //!   0                   1                   2                   3
@@ -46,6 +54,12 @@ struct IPv4Header {
     uint32_t dst = 0;           //!< dst address
     //!@}
 
+    //! The ECN codepoint in `tos`
+    ECN ecn() const { return static_cast<ECN>(tos & 0b11); }
+
+    //! Set the ECN codepoint, leaving the DSCP in the rest of `tos` alone
+    void set_ecn(const ECN ecn) { tos = static_cast<uint8_t>((tos & ~0b11) | static_cast<uint8_t>(ecn)); }
+
     //! Parse the IP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
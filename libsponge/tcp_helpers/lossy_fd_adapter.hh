@@ -48,8 +48,15 @@ class LossyFdAdapter {
     }
 
     //! \brief Write to the underlying AdapterT instance, potentially dropping the datagram to be written
+    //! \details The wire segments of a super-segment (see TCPConfig::tso_size) are dropped independently.
     //! \param[in] seg is the packet to either write or drop
     void write(TCPSegment &seg) {
+        if (seg.needs_split()) {
+            for (auto &piece : seg.split(seg.wire_mss())) {
+                write(piece);
+            }
+            return;
+        }
         if (_should_drop(true)) {
             return;
         }
@@ -63,6 +70,7 @@ class LossyFdAdapter {
     void set_listening(const bool l) { _adapter.set_listening(l); }      //!< FdAdapterBase::set_listening passthrough
     const FdAdapterConfig &config() const { return _adapter.config(); }  //!< FdAdapterBase::config passthrough
     FdAdapterConfig &config_mut() { return _adapter.config_mut(); }      //!< FdAdapterBase::config_mut passthrough
+    size_t mss_hint() { return _adapter.mss_hint(); }                    //!< FdAdapterBase::mss_hint passthrough
     void tick(const size_t ms_since_last_tick) {
         _adapter.tick(ms_since_last_tick);
     }  //!< FdAdapterBase::tick passthrough
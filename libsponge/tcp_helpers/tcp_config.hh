@@ -2,6 +2,8 @@
 #define SPONGE_LIBSPONGE_TCP_CONFIG_HH
 
 #include "address.hh"
+#include "congestion_controller.hh"
+#include "stream_reassembler.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
@@ -12,14 +14,36 @@
 class TCPConfig {
   public:
     static constexpr size_t DEFAULT_CAPACITY = 64000;  //!< Default capacity
-    static constexpr size_t MAX_PAYLOAD_SIZE = 1000;   //!< Conservative max payload size for real Internet
+    static constexpr size_t MAX_PAYLOAD_SIZE = 1000;   //!< Conservative max payload size for real Internet (see mss)
     static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
     static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
+    static constexpr uint32_t RTO_MIN_DFLT = 200;      //!< Default floor of an adaptive RTO (Linux's; RFC 6298 has 1 s)
+    static constexpr uint32_t RTO_MAX_DFLT = 60000;    //!< Default ceiling of an adaptive RTO, including backoff
+    static constexpr size_t MAX_TSO_SIZE = 64 * MAX_PAYLOAD_SIZE;  //!< Largest super-segment payload (see tso_size)
+    static constexpr uint16_t DELAYED_ACK_TIMEOUT_DFLT = 40;        //!< Default delayed-ACK timer (as Linux's minimum)
 
     uint16_t rt_timeout = TIMEOUT_DFLT;       //!< Initial value of the retransmission timeout, in milliseconds
+    bool adaptive_rto = false;                //!< Derive the RTO from measured RTTs (RFC 6298) after the first sample
+    uint32_t rto_min = RTO_MIN_DFLT;          //!< Lower bound of an adaptive RTO, in milliseconds
+    uint32_t rto_max = RTO_MAX_DFLT;          //!< Upper bound of an adaptive RTO, in milliseconds
+    bool fast_retransmit = true;              //!< Retransmit on the third duplicate ACK, with NewReno fast recovery
+    bool sack = true;                         //!< Offer and use selective acknowledgments (RFC 2018, RFC 6675)
+    bool rack = true;                         //!< With SACK, RACK-TLP loss detection and tail loss probes (RFC 8985)
+    bool window_scaling = true;               //!< Offer the window-scale option (RFC 7323) for windows over 64 KiB
+    bool timestamps = true;                   //!< Offer timestamps (RFC 7323): an RTT sample per ACK, and PAWS
+    bool ecn = false;                         //!< Negotiate ECN (RFC 3168) and react to CE marks (DCTCP always does)
+    uint64_t pacing_rate = 0;                 //!< Pacing rate in bytes/s; 0 follows the congestion controller
+    size_t mss = 0;  //!< Largest payload to receive (offered on the SYN) and send (0: the adapter's hint, if any)
+    size_t tso_size = 0;  //!< Payload limit of sent segments, cut to the MSS by the adapter (0: no offload)
+    bool nodelay = true;                      //!< Send small segments at once; false applies Nagle's algorithm
+    bool delayed_ack = false;                 //!< ACK every second full-size segment, or after delayed_ack_timeout
+    uint16_t delayed_ack_timeout = DELAYED_ACK_TIMEOUT_DFLT;  //!< Longest an ACK is delayed, in milliseconds
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
     std::optional<WrappingInt32> fixed_isn{};
+    bool double_mapped_buffers = false;  //!< Back the stream buffers with magic rings (needs page-aligned capacities)
+    StreamReassembler::Engine reassembler_engine = StreamReassembler::Engine::Interval;  //!< Receive-side reassembly
+    CongestionController::Algorithm congestion_control = CongestionController::Algorithm::NewReno;  //!< Sender's policy
 };
 
 //! Config for classes derived from FdAdapter
@@ -1,9 +1,73 @@
 #include "tcp_header.hh"
 
+#include <algorithm>
 #include <sstream>
 
 using namespace std;
 
+//! \name Option kinds (RFC 793, RFC 7323, RFC 2018)
+//!@{
+static constexpr uint8_t OPTION_END = 0;
+static constexpr uint8_t OPTION_NOP = 1;
+static constexpr uint8_t OPTION_MSS = 2;
+static constexpr uint8_t OPTION_WINDOW_SCALE = 3;
+static constexpr uint8_t OPTION_SACK_PERMITTED = 4;
+static constexpr uint8_t OPTION_SACK = 5;
+static constexpr uint8_t OPTION_TIMESTAMPS = 8;
+//!@}
+
+//! Bytes a SACK option with `blocks` blocks takes, with the two NOPs that align it
+static size_t sack_option_length(const size_t blocks) { return blocks == 0 ? 0 : 4 + 8 * blocks; }
+
+//! \details Options are aligned with NOPs, as most stacks send them, so every option takes a
+//! multiple of 4 bytes. The SACK option is cut down to the blocks that fit.
+size_t TCPHeader::options_length() const {
+    const size_t fixed = (mss.has_value() ? 4 : 0) + (window_scale.has_value() ? 4 : 0) + (sack_permitted ? 4 : 0) +
+                         (timestamps.has_value() ? 12 : 0);
+    const auto room = (MAX_LENGTH - LENGTH - fixed - 4) / 8;
+    return fixed + sack_option_length(min(sack_blocks.size(), room));
+}
+
+//! \brief Parse the options (the bytes between the fixed header and the data) into `header`
+//! \details Like most stacks, a malformed option (one whose length runs past the
+//! option space) ends option processing rather than failing the segment.
+static void parse_options(NetParser p, TCPHeader &header) {
+    while (p.buffer().size() > 0) {
+        const auto kind = p.u8();
+        if (kind == OPTION_END) {
+            return;
+        }
+        if (kind == OPTION_NOP) {
+            continue;
+        }
+        if (p.buffer().size() == 0) {
+            return;
+        }
+        const size_t len = p.u8();
+        if (len < 2 or len - 2 > p.buffer().size()) {
+            return;
+        }
+
+        if (kind == OPTION_MSS and len == 4) {
+            header.mss = p.u16();
+        } else if (kind == OPTION_WINDOW_SCALE and len == 3) {
+            header.window_scale = p.u8();
+        } else if (kind == OPTION_SACK_PERMITTED and len == 2) {
+            header.sack_permitted = true;
+        } else if (kind == OPTION_TIMESTAMPS and len == 10) {
+            const auto value = p.u32();
+            header.timestamps = TCPTimestamps{value, p.u32()};
+        } else if (kind == OPTION_SACK and (len - 2) % 8 == 0) {
+            for (size_t i = 0; i < (len - 2) / 8; ++i) {
+                const WrappingInt32 left{p.u32()};
+                header.sack_blocks.push_back({left, WrappingInt32{p.u32()}});
+            }
+        } else {
+            p.remove_prefix(len - 2);
+        }
+    }
+}
+
 //! \param[in,out] p is a NetParser from which the TCP fields will be extracted
 //! \returns a ParseResult indicating success or the reason for failure
 //! \details It is important to check for (at least) the following potential errors
@@ -22,6 +86,8 @@ ParseResult TCPHeader::parse(NetParser &p) {
     doff = p.u8() >> 4;              // data offset
 
     const uint8_t fl_b = p.u8();                  // byte including flags
+    cwr = static_cast<bool>(fl_b & 0b1000'0000);
+    ece = static_cast<bool>(fl_b & 0b0100'0000);
     urg = static_cast<bool>(fl_b & 0b0010'0000);  // binary literals and ' digit separator since C++14!!!
     ack = static_cast<bool>(fl_b & 0b0001'0000);
     psh = static_cast<bool>(fl_b & 0b0000'1000);
@@ -37,8 +103,17 @@ ParseResult TCPHeader::parse(NetParser &p) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
+    // parse the options we understand, skip the rest
+    const size_t options_len = doff * 4 - TCPHeader::LENGTH;
+    mss.reset();
+    window_scale.reset();
+    sack_permitted = false;
+    timestamps.reset();
+    sack_blocks.clear();
+    if (not p.error() and p.buffer().size() >= options_len) {
+        parse_options(NetParser{p.buffer().substr(0, options_len)}, *this);
+    }
+    p.remove_prefix(options_len);
 
     if (p.error()) {
         return p.get_error();
@@ -63,8 +138,9 @@ string TCPHeader::serialize() const {
     NetUnparser::u32(ret, ackno.raw_value());  // ack number
     NetUnparser::u8(ret, doff << 4);           // data offset
 
-    const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
-                         (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
+    const uint8_t fl_b = (cwr ? 0b1000'0000 : 0) | (ece ? 0b0100'0000 : 0) | (urg ? 0b0010'0000 : 0) |
+                         (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) | (rst ? 0b0000'0100 : 0) |
+                         (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
     NetUnparser::u8(ret, fl_b);  // flags
     NetUnparser::u16(ret, win);  // window size
 
@@ -72,7 +148,48 @@ string TCPHeader::serialize() const {
 
     NetUnparser::u16(ret, uptr);  // urgent pointer
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    // options, as far as doff leaves room for them
+    const size_t room = 4 * doff - LENGTH;
+    size_t used = 0;
+    if (mss.has_value() and used + 4 <= room) {
+        NetUnparser::u8(ret, OPTION_MSS);
+        NetUnparser::u8(ret, 4);
+        NetUnparser::u16(ret, mss.value());
+        used += 4;
+    }
+    if (window_scale.has_value() and used + 4 <= room) {
+        for (const uint8_t byte : {OPTION_NOP, OPTION_WINDOW_SCALE, uint8_t{3}, window_scale.value()}) {
+            NetUnparser::u8(ret, byte);
+        }
+        used += 4;
+    }
+    if (sack_permitted and used + 4 <= room) {
+        for (const uint8_t byte : {OPTION_NOP, OPTION_NOP, OPTION_SACK_PERMITTED, uint8_t{2}}) {
+            NetUnparser::u8(ret, byte);
+        }
+        used += 4;
+    }
+    if (timestamps.has_value() and used + 12 <= room) {
+        for (const uint8_t byte : {OPTION_NOP, OPTION_NOP, OPTION_TIMESTAMPS, uint8_t{10}}) {
+            NetUnparser::u8(ret, byte);
+        }
+        NetUnparser::u32(ret, timestamps.value().value);
+        NetUnparser::u32(ret, timestamps.value().echo);
+        used += 12;
+    }
+    const auto blocks = min(sack_blocks.size(), room >= used + 4 ? (room - used - 4) / 8 : 0);
+    if (blocks > 0) {
+        NetUnparser::u8(ret, OPTION_NOP);
+        NetUnparser::u8(ret, OPTION_NOP);
+        NetUnparser::u8(ret, OPTION_SACK);
+        NetUnparser::u8(ret, 2 + 8 * blocks);
+        for (size_t i = 0; i < blocks; ++i) {
+            NetUnparser::u32(ret, sack_blocks[i].left.raw_value());
+            NetUnparser::u32(ret, sack_blocks[i].right.raw_value());
+        }
+    }
+
+    ret.resize(4 * doff);  // expand header to advertised size (the padding is all END options)
 
     return ret;
 }
@@ -86,23 +203,44 @@ string TCPHeader::to_string() const {
        << "TCP ackno: " << ackno << '\n'
        << "TCP doff: " << +doff << '\n'
        << "Flags: urg: " << urg << " ack: " << ack << " psh: " << psh << " rst: " << rst << " syn: " << syn
-       << " fin: " << fin << '\n'
+       << " fin: " << fin << " ece: " << ece << " cwr: " << cwr << '\n'
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
-       << "TCP uptr: " << +uptr << '\n';
+       << "TCP uptr: " << +uptr << '\n'
+       << "TCP options: mss: " << (mss.has_value() ? std::to_string(mss.value()) : "none")
+       << " window_scale: " << (window_scale.has_value() ? std::to_string(window_scale.value()) : "none")
+       << " sack_permitted: " << sack_permitted << " timestamps: "
+       << (timestamps.has_value() ? std::to_string(timestamps->value) + "/" + std::to_string(timestamps->echo)
+                                  : "none")
+       << " sack blocks: " << dec << sack_blocks.size() << '\n';
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << (ece ? "E" : "") << (cwr ? "W" : "") << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win;
+    if (mss.has_value()) {
+        ss << ",mss=" << mss.value();
+    }
+    if (window_scale.has_value()) {
+        ss << ",wscale=" << +window_scale.value();
+    }
+    if (timestamps.has_value()) {
+        ss << ",ts=" << timestamps.value().value << "/" << timestamps.value().echo;
+    }
+    for (const auto &block : sack_blocks) {
+        ss << ",sack=" << block.left << "-" << block.right;
+    }
+    ss << ")";
     return ss.str();
 }
 
 bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
     return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
-           psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+           psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && cwr == other.cwr &&
+           ece == other.ece && win == other.win && uptr == other.uptr && mss == other.mss &&
+           window_scale == other.window_scale && sack_permitted == other.sack_permitted &&
+           timestamps == other.timestamps && sack_blocks == other.sack_blocks;
 }
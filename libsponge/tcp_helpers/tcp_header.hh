@@ -4,10 +4,34 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <optional>
+#include <vector>
+
+//! \brief A range of sequence space [left, right) that a receiver holds out of order (RFC 2018)
+struct TCPSackBlock {
+    WrappingInt32 left{0};   //!< First sequence number of the block
+    WrappingInt32 right{0};  //!< Sequence number just past the block
+
+    bool operator==(const TCPSackBlock &other) const { return left == other.left and right == other.right; }
+};
+
+//! \brief The timestamps option (RFC 7323)
+struct TCPTimestamps {
+    uint32_t value = 0;  //!< TSval: the sender's clock, in milliseconds, when it sent the segment
+    uint32_t echo = 0;   //!< TSecr: the TSval the sender last took from its peer (0 on a SYN)
+
+    bool operator==(const TCPTimestamps &other) const { return value == other.value and echo == other.echo; }
+};
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
+//! \note The CWR and ECE flags are those of ECN (RFC 3168). Of the TCP options, only MSS (RFC 793),
+//! window scale and timestamps (RFC 7323), SACK-permitted and SACK (RFC 2018) are understood; others
+//! are skipped
 struct TCPHeader {
     static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t MAX_LENGTH = 60;  //!< Header length including the most options `doff` can describe
+    static constexpr size_t MAX_SACK_BLOCKS = 4;  //!< SACK blocks that fit in the option space on their own
+    static constexpr uint8_t MAX_WINDOW_SCALE = 14;  //!< Largest window shift (RFC 7323): windows up to 1 GiB
 
     //! \struct TCPHeader
     //! ~~~{.txt}
@@ -20,9 +44,9 @@ struct TCPHeader {
     //!  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
     //!  |                    Acknowledgment Number                      |
     //!  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-    //!  |  Data |           |U|A|P|R|S|F|                               |
-    //!  | Offset| Reserved  |R|C|S|S|Y|I|            Window             |
-    //!  |       |           |G|K|H|T|N|N|                               |
+    //!  |  Data |       |C|E|U|A|P|R|S|F|                               |
+    //!  | Offset| Rsrvd |W|C|R|C|S|S|Y|I|            Window             |
+    //!  |       |       |R|E|G|K|H|T|N|N|                               |
     //!  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
     //!  |           Checksum            |         Urgent Pointer        |
     //!  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
@@ -39,6 +63,8 @@ struct TCPHeader {
     WrappingInt32 seqno{0};     //!< sequence number
     WrappingInt32 ackno{0};     //!< ack number
     uint8_t doff = LENGTH / 4;  //!< data offset
+    bool cwr = false;           //!< congestion window reduced flag (ECN)
+    bool ece = false;           //!< ECN-echo flag
     bool urg = false;           //!< urgent flag
     bool ack = false;           //!< ack flag
     bool psh = false;           //!< push flag
@@ -50,6 +76,20 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! \name TCP options
+    //! \details serialize() writes the options that fit in the space `doff` leaves for them,
+    //! in the order below; options_length() tells how much space that takes.
+    //!@{
+    std::optional<uint16_t> mss{};               //!< MSS option: the largest payload the sender accepts
+    std::optional<uint8_t> window_scale{};       //!< Window-scale option: shift of the sender's later `win`s (SYN only)
+    bool sack_permitted = false;                 //!< SACK-permitted option (only on SYN segments)
+    std::optional<TCPTimestamps> timestamps{};   //!< Timestamps option (with it, only three SACK blocks fit)
+    std::vector<TCPSackBlock> sack_blocks{};     //!< SACK option, most recently changed block first
+    //!@}
+
+    //! Bytes the options take in the header, padded to a multiple of 4
+    size_t options_length() const;
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
@@ -2,6 +2,7 @@
 #define SPONGE_LIBSPONGE_TCP_OVER_IP_HH
 
 #include "buffer.hh"
+#include "ethernet_header.hh"
 #include "fd_adapter.hh"
 #include "ipv4_datagram.hh"
 #include "tcp_segment.hh"
@@ -11,6 +12,12 @@
 //! \brief A converter from TCP segments to serialized IPv4 datagrams
 class TCPOverIPv4Adapter : public FdAdapterBase {
   public:
+    //! The largest TCP payload in an IPv4 datagram of `mtu` bytes, leaving room for the largest TCP header
+    static constexpr size_t mss_for_mtu(const size_t mtu) { return mtu - IPv4Header::LENGTH - TCPHeader::MAX_LENGTH; }
+
+    //! For a TUN device's default MTU, which is Ethernet's
+    size_t mss_hint() const { return mss_for_mtu(EthernetHeader::MTU); }
+
     std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram);
 
     InternetDatagram wrap_tcp_in_ip(TCPSegment &seg);
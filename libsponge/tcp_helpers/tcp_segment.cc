@@ -3,6 +3,8 @@
 #include "parser.hh"
 #include "util.hh"
 
+#include <algorithm>
+#include <stdexcept>
 #include <variant>
 
 using namespace std;
@@ -22,6 +24,28 @@ ParseResult TCPSegment::parse(const Buffer buffer, const uint32_t datagram_layer
     return p.get_error();
 }
 
+//! \param[in] mss is the largest payload of a piece
+std::vector<TCPSegment> TCPSegment::split(const size_t mss) const {
+    if (mss == 0) {
+        throw runtime_error("TCPSegment::split: mss must be positive");
+    }
+    vector<TCPSegment> pieces;
+    pieces.reserve(max<size_t>(1, (_payload.size() + mss - 1) / mss));
+    for (size_t offset = 0; pieces.empty() or offset < _payload.size(); offset += mss) {
+        TCPSegment &piece = pieces.emplace_back();
+        piece._header = _header;
+        piece._payload = _payload.substr(offset, mss);
+        piece._ecn = _ecn;
+        if (offset > 0) {
+            piece._header.seqno = _header.seqno + static_cast<uint32_t>(offset + (_header.syn ? 1 : 0));
+            piece._header.syn = false;
+            piece._header.cwr = false;
+        }
+        piece._header.fin = _header.fin and offset + mss >= _payload.size();
+    }
+    return pieces;
+}
+
 size_t TCPSegment::length_in_sequence_space() const {
     return payload().str().size() + (header().syn ? 1 : 0) + (header().fin ? 1 : 0);
 }
@@ -2,15 +2,19 @@
 #define SPONGE_LIBSPONGE_TCP_SEGMENT_HH
 
 #include "buffer.hh"
+#include "ipv4_header.hh"
 #include "tcp_header.hh"
 
 #include <cstdint>
+#include <vector>
 
 //! \brief [TCP](\ref rfc::rfc793) segment
 class TCPSegment {
   private:
     TCPHeader _header{};
     Buffer _payload{};
+    size_t _wire_mss = 0;  //!< Not on the wire: see wire_mss()
+    IPv4Header::ECN _ecn = IPv4Header::ECN::NotECT;  //!< Not in the TCP header: see ecn()
 
   public:
     //! \brief Parse the segment from a string
@@ -28,6 +32,24 @@ class TCPSegment {
     Buffer &payload() { return _payload; }
     //!@}
 
+    //! \brief Cut the segment into wire segments of at most `mss` payload bytes (segmentation offload)
+    //! \details Each piece gets a copy of the header, with its seqno advanced, and a slice of the payload
+    //! that shares its storage. SYN and CWR stay on the first piece and FIN on the last; all keep the ECN codepoint.
+    std::vector<TCPSegment> split(const size_t mss) const;
+
+    //! \brief Payload limit of the wire segments the adapter cuts a super-segment into (0: send it whole)
+    //! \details Set by the TCPSender to the connection's MSS, as Linux tags an skb with its GSO size
+    size_t wire_mss() const { return _wire_mss; }
+    void set_wire_mss(const size_t mss) { _wire_mss = mss; }
+
+    //! \brief ECN codepoint of the datagram that carried the segment, or is to carry it (RFC 3168)
+    //! \details Set by the TCPSender on data it sends (ECT) and copied to and from the IP header by the adapter
+    IPv4Header::ECN ecn() const { return _ecn; }
+    void set_ecn(const IPv4Header::ECN ecn) { _ecn = ecn; }
+
+    //! Whether the segment must be cut with `split(wire_mss())` before it goes on the wire
+    bool needs_split() const { return _wire_mss > 0 and _payload.size() > _wire_mss; }
+
     //! \brief Segment's length in sequence space
     //! \note Equal to payload length plus one byte if SYN is set, plus one byte if FIN is set
     size_t length_in_sequence_space() const;
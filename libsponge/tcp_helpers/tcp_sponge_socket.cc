@@ -25,14 +25,23 @@ template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
     auto base_time = timestamp_ms();
     while (condition()) {
-        auto ret = _eventloop.wait_next_event(TCP_TICK_MS);
+        // wake up early for the connection's next timer (a retransmission, or pacing's release, say)
+        auto timeout = TCP_TICK_MS;
+        if (_tcp.has_value()) {
+            timeout = min<size_t>(timeout, _tcp.value().ms_until_timeout().value_or(TCP_TICK_MS));
+        }
+        auto ret = _eventloop.wait_next_event(static_cast<int>(timeout));
         if (ret == EventLoop::Result::Exit or _abort) {
             break;
         }
 
         if (_tcp.value().active()) {
+            _tcp.value().set_nodelay(_nodelay);
+            _tcp.value().set_corked(_corked);
             const auto next_time = timestamp_ms();
-            _tcp.value().tick(next_time - base_time);
+            // only the timers that come due call into the connection
+            _timers.advance(next_time - base_time,
+                            [&](const uint64_t key) { _tcp.value().timer_expired(TCPTimers::kind_of(key)); });
             _datagram_adapter.tick(next_time - base_time);
             base_time = next_time;
         }
@@ -52,7 +61,12 @@ TCPSpongeSocket<AdaptT>::TCPSpongeSocket(pair<FileDescriptor, FileDescriptor> da
 
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
-    _tcp.emplace(config);
+    TCPConfig tcp_config = config;
+    if (tcp_config.mss == 0) { // segments as large as the link carries
+        tcp_config.mss = _datagram_adapter.mss_hint();
+    }
+    _tcp.emplace(tcp_config, _timers, 0);
+    _nodelay = config.nodelay;
 
     // Set up the event loop
 
@@ -96,9 +110,9 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
         _thread_data,
         Direction::In,
         [&] {
-            const auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
+            auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
             const auto len = data.size();
-            const auto amount_written = _tcp->write(move(data));
+            const auto amount_written = _tcp->write(Buffer{move(data)});  // segments slice this read's storage
             if (amount_written != len) {
                 throw runtime_error("TCPConnection::write() accepted less than advertised length");
             }
@@ -129,9 +143,9 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
             // the pipe, handling the possibility of a partial
             // write (i.e., only pop what was actually written).
             const size_t amount_to_write = min(size_t(65536), inbound.buffer_size());
-            const std::string buffer = inbound.peek_output(amount_to_write);
-            const auto bytes_written = _thread_data.write(move(buffer), false);
+            const auto bytes_written = _thread_data.write(inbound.peek_spans(amount_to_write), false);
             inbound.pop_output(bytes_written);
+            _tcp->inbound_stream_read();
 
             if (inbound.eof() or inbound.error()) {
                 _thread_data.shutdown(SHUT_WR);
@@ -208,17 +222,17 @@ void TCPSpongeSocket<AdaptT>::connect(const TCPConfig &c_tcp, const FdAdapterCon
         throw runtime_error("connect() with TCPConnection already initialized");
     }
 
+    _datagram_adapter.config_mut() = c_ad;  // first: the adapter's MSS hint may depend on the destination
     _initialize_TCP(c_tcp);
 
-    _datagram_adapter.config_mut() = c_ad;
-
     cerr << "DEBUG: Connecting to " << c_ad.destination.to_string() << "...\n";
     _tcp->connect();
 
     const TCPState expected_state = TCPState::State::SYN_SENT;
 
-    if (_tcp->state() != expected_state) {
-        throw runtime_error("After TCPConnection::connect(), state was " + _tcp->state().name() + " but expected " +
+    const TCPState state = _tcp->state();
+    if (state != expected_state) {
+        throw runtime_error("After TCPConnection::connect(), state was " + state.name() + " but expected " +
                             expected_state.name());
     }
 
@@ -236,10 +250,9 @@ void TCPSpongeSocket<AdaptT>::listen_and_accept(const TCPConfig &c_tcp, const Fd
         throw runtime_error("listen_and_accept() with TCPConnection already initialized");
     }
 
-    _initialize_TCP(c_tcp);
-
     _datagram_adapter.config_mut() = c_ad;
     _datagram_adapter.set_listening(true);
+    _initialize_TCP(c_tcp);
 
     cerr << "DEBUG: Listening for incoming connection...\n";
     _tcp_loop([&] {
@@ -8,6 +8,7 @@
 #include "network_interface.hh"
 #include "tcp_config.hh"
 #include "tcp_connection.hh"
+#include "timing_wheel.hh"
 #include "tuntap_adapter.hh"
 
 #include <atomic>
@@ -31,7 +32,10 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! Set up the TCPConnection and the event loop
     void _initialize_TCP(const TCPConfig &config);
 
-    //! TCP state machine
+    //! The TCPConnection's timers; the loop advances it rather than ticking the connection
+    TimingWheel _timers{};
+
+    //! TCP state machine, with its timers on _timers (so declared after it)
     std::optional<TCPConnection> _tcp{};
 
     //! eventloop that handles all the events (new inbound datagram, new outbound bytes, new inbound bytes)
@@ -57,6 +61,12 @@ class TCPSpongeSocket : public LocalStreamSocket {
 
     bool _fully_acked{false};  //!< Has the outbound data been fully acknowledged by the peer?
 
+    //! \name Coalescing modes requested by the owner, applied by the TCPConnection thread
+    //!@{
+    std::atomic_bool _nodelay{true};
+    std::atomic_bool _corked{false};
+    //!@}
+
   public:
     //! Construct from the interface that the TCPConnection thread will use to read and write datagrams
     explicit TCPSpongeSocket(AdaptT &&datagram_interface);
@@ -72,6 +82,22 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! Listen and accept using the specified configurations; blocks until accept succeeds or fails
     void listen_and_accept(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad);
 
+    //! \name Coalescing of small writes
+    //! Take effect within one tick of the TCPConnection thread; until connect() or listen_and_accept(),
+    //! TCPConfig::nodelay sets the mode.
+    //!@{
+
+    //! Send small writes at once (like TCP_NODELAY), or coalesce them with Nagle's algorithm
+    void set_nodelay(const bool nodelay) { _nodelay = nodelay; }
+
+    //! \brief Hold partial segments (like TCP_CORK) until uncork()
+    //! \note Unlike TCP_CORK, there is no 200 ms limit: uncork() must be called
+    void cork() { _corked = true; }
+
+    //! Send any partial segment that cork() held back
+    void uncork() { _corked = false; }
+    //!@}
+
     //! When a connected socket is destructed, it will send a RST
     ~TCPSpongeSocket();
 
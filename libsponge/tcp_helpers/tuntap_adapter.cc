@@ -42,9 +42,15 @@ void TCPOverIPv4OverEthernetAdapter::tick(const size_t ms_since_last_tick) {
     send_pending();
 }
 
-//! \param[in] seg the TCPSegment to send
+//! \param[in] seg the TCPSegment to send (a super-segment is cut into wire segments first)
 void TCPOverIPv4OverEthernetAdapter::write(TCPSegment &seg) {
-    _interface.send_datagram(wrap_tcp_in_ip(seg), _next_hop);
+    if (not seg.needs_split()) {
+        _interface.send_datagram(wrap_tcp_in_ip(seg), _next_hop);
+    } else {
+        for (auto &piece : seg.split(seg.wire_mss())) {
+            _interface.send_datagram(wrap_tcp_in_ip(piece), _next_hop);
+        }
+    }
     send_pending();
 }
 
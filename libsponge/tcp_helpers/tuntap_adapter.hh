@@ -27,8 +27,17 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
         return unwrap_tcp_in_ip(ip_dgram);
     }
 
-    //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-    void write(TCPSegment &seg) { _tun.write(wrap_tcp_in_ip(seg).serialize()); }
+    //! Creates an IPv4 datagram from a TCP segment (from each wire segment of a super-segment)
+    //! and writes it to the TUN device
+    void write(TCPSegment &seg) {
+        if (not seg.needs_split()) {
+            _tun.write(wrap_tcp_in_ip(seg).serialize());
+            return;
+        }
+        for (auto &piece : seg.split(seg.wire_mss())) {
+            _tun.write(wrap_tcp_in_ip(piece).serialize());
+        }
+    }
 
     //! Access the underlying TUN device
     operator TunFD &() { return _tun; }
@@ -1,5 +1,7 @@
 #include "tcp_receiver.hh"
 
+#include <algorithm>
+
 // Dummy implementation of a TCP receiver
 
 // For Lab 2, please replace with a real implementation that passes the
@@ -17,12 +19,68 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
     if (!_isn.has_value()) { // no SYN received before
         if (!header.syn) return; // if the current segment is not SYN, discard it
         _isn = header.seqno; // if the current segment is SYN, the seqno is isn
+        _sack_permitted = header.sack_permitted;
+        _mss = header.mss;
+        if (header.window_scale.has_value()) { // shifts beyond the maximum are taken as the maximum
+            _window_scale = min(header.window_scale.value(), TCPHeader::MAX_WINDOW_SCALE);
+        }
+        if (header.timestamps.has_value()) {
+            _ts_recent = header.timestamps.value().value;
+        }
+        _ecn_setup = header.ece && header.cwr != header.ack; // the SYN/ACK of a peer that accepts clears CWR
+    } else if (stale(seg)) {
+        return;
+    }
+
+    // CE marks are latched until the sender says it has reduced its window; the CWR comes first,
+    // in case the same segment was marked again
+    if (_ecn_setup) {
+        if (header.cwr) _ece_latched = false;
+        if (seg.ecn() == IPv4Header::ECN::CE) _ece_latched = true;
+        if (seg.payload().size() > 0) _last_ce = seg.ecn() == IPv4Header::ECN::CE;
     }
     
     uint64_t checkpoint = _reassembler.stream_out().bytes_written(); // index of the last reassmebled byte (with SYN)
     uint64_t abs_seqno = unwrap(header.seqno, _isn.value(), checkpoint);
     uint64_t stream_index = abs_seqno - 1 + (header.syn ? 1: 0); // the same only if the current segment is SYN, otherwise increase by 1 for the SYN processed before
-    _reassembler.push_substring(seg.payload().copy(), stream_index, header.fin); // FIN signals eof
+    // the echoed timestamp follows the segments that cover the last ACK sent (RFC 7323 4.3), so that
+    // it times the oldest data the next ACK acknowledges (and a retransmission by its new stamp)
+    if (_ts_recent.has_value() && header.timestamps.has_value() && !header.syn && stream_index <= _last_ack_sent) {
+        _ts_recent = header.timestamps.value().value;
+    }
+    // FIN signals eof; the payload is sliced, not copied
+    _reassembler.push_substring(seg.payload(), stream_index, header.fin);
+    if (stream_index > _reassembler.stream_out().bytes_written() && seg.payload().size() > 0) {
+        _last_out_of_order = stream_index;
+    }
+}
+
+bool TCPReceiver::stale(const TCPSegment &seg) const {
+    const auto &header = seg.header();
+    if (!_ts_recent.has_value() || !header.timestamps.has_value() || header.syn || header.rst) return false;
+    // timestamps wrap too: "before" is less than half the clock's range behind
+    return static_cast<int32_t>(header.timestamps.value().value - _ts_recent.value()) < 0;
+}
+
+vector<TCPSackBlock> TCPReceiver::sack_blocks() const {
+    vector<TCPSackBlock> blocks;
+    if (!_isn.has_value() || _reassembler.empty()) return blocks;
+
+    // stream index i is absolute seqno i + 1, after the SYN
+    const auto ranges = _reassembler.pending_ranges();
+    const auto block = [&](const pair<uint64_t, uint64_t> &range) {
+        return TCPSackBlock{wrap(range.first + 1, _isn.value()), wrap(range.second + 1, _isn.value())};
+    };
+    const auto latest = find_if(ranges.begin(), ranges.end(), [&](const pair<uint64_t, uint64_t> &range) {
+        return range.first <= _last_out_of_order && _last_out_of_order < range.second;
+    });
+    if (latest != ranges.end()) {
+        blocks.push_back(block(*latest));
+    }
+    for (auto it = ranges.begin(); it != ranges.end() && blocks.size() < TCPHeader::MAX_SACK_BLOCKS; ++it) {
+        if (it != latest) blocks.push_back(block(*it));
+    }
+    return blocks;
 }
 
 // Return the expected ackno and check if SYN has been received
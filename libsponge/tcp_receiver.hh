@@ -7,6 +7,7 @@
 #include "wrapping_integers.hh"
 
 #include <optional>
+#include <vector>
 
 //! \brief The "receiver" part of a TCP implementation.
 
@@ -25,12 +26,42 @@ class TCPReceiver {
     // If it has no value, then we haven't received a SYN yet; SYN flag is 0
     std::optional<WrappingInt32> _isn;
 
+    //! Whether the sender's SYN carried the SACK-permitted option
+    bool _sack_permitted = false;
+
+    //! The window shift the sender's SYN offered, if it carried the window-scale option
+    std::optional<uint8_t> _window_scale{};
+
+    //! The MSS the sender's SYN announced, if it carried the option
+    std::optional<uint16_t> _mss{};
+
+    //! TS.Recent (RFC 7323): the timestamp to echo, if the sender's SYN carried the timestamps option
+    std::optional<uint32_t> _ts_recent{};
+
+    //! Last.ACK.sent (RFC 7323), as a stream index: what the last ACK sent acknowledged
+    uint64_t _last_ack_sent = 0;
+
+    //! Stream index of the last segment that arrived out of order (its block is reported first)
+    uint64_t _last_out_of_order = 0;
+
+    //! \name ECN (RFC 3168)
+    //!@{
+    bool _ecn_setup = false;    //!< The sender's SYN set up ECN (a SYN with ECE and CWR, a SYN/ACK with ECE only)
+    bool _ece_latched = false;  //!< A CE mark arrived, and no CWR since
+    bool _last_ce = false;      //!< The latest data segment was marked CE
+    //!@}
+
   public:
     //! \brief Construct a TCP receiver
     //!
     //! \param capacity the maximum number of bytes that the receiver will
     //!                 store in its buffers at any give time.
-    TCPReceiver(const size_t capacity) : _reassembler(capacity), _capacity(capacity), _isn() {}
+    //! \param double_mapped requests magic-ring storage for the reassembler (see RingStorage)
+    //! \param engine selects the reassembler's storage (see StreamReassembler::Engine)
+    TCPReceiver(const size_t capacity,
+                const bool double_mapped = false,
+                const StreamReassembler::Engine engine = StreamReassembler::Engine::Interval)
+        : _reassembler(capacity, double_mapped, engine), _capacity(capacity), _isn() {}
 
     //! \name Accessors to provide feedback to the remote TCPSender
     //!@{
@@ -53,12 +84,52 @@ class TCPReceiver {
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
     size_t window_size() const;
+
+    //! \brief Whether the sender offered SACK (RFC 2018) on its SYN
+    bool sack_permitted() const { return _sack_permitted; }
+
+    //! \brief The largest payload the sender accepts, from the MSS option on its SYN
+    //! \returns empty if its SYN did not carry the option
+    std::optional<uint16_t> mss() const { return _mss; }
+
+    //! \brief The shift the sender will apply to its window advertisements after the SYN (RFC 7323)
+    //! \returns empty if its SYN did not carry the window-scale option
+    std::optional<uint8_t> window_scale() const { return _window_scale; }
+
+    //! \brief The timestamp to echo to the sender (RFC 7323): that of the latest segment to cover the
+    //! last ACK sent (see ack_sent())
+    //! \returns empty if its SYN did not carry the timestamps option
+    std::optional<uint32_t> ts_recent() const { return _ts_recent; }
+
+    //! \brief Note that an ACK of everything received so far has gone out (Last.ACK.sent)
+    //! \details Until the next one, TS.Recent stays with the segment that ACK covered, so that a
+    //! delayed ACK echoes the oldest of the segments it acknowledges.
+    void ack_sent() { _last_ack_sent = _reassembler.stream_out().bytes_written(); }
+
+    //! \brief Whether the sender's SYN set up ECN (RFC 3168); without it, CE marks are not tracked
+    bool ecn_setup() const { return _ecn_setup; }
+
+    //! \brief Whether ACKs should carry ECE the classic way: from a CE mark until the sender's CWR (RFC 3168)
+    bool ece_latched() const { return _ece_latched; }
+
+    //! \brief Whether the latest data segment was marked CE: what DCTCP echoes on each ACK (RFC 8257)
+    bool last_ce() const { return _last_ce; }
+
+    //! \brief The blocks held out of order, for the SACK option
+    //! \returns at most TCPHeader::MAX_SACK_BLOCKS blocks: the one holding the most recent
+    //! out-of-order segment first, then the others in sequence order
+    std::vector<TCPSackBlock> sack_blocks() const;
     //!@}
 
     //! \brief number of bytes stored but not yet reassembled
     size_t unassembled_bytes() const { return _reassembler.unassembled_bytes(); }
 
-    //! \brief handle an inbound segment
+    //! \brief Whether PAWS (RFC 7323) rejects `seg` as an old duplicate: it is stamped before TS.Recent
+    //! \details Sequence numbers wrap within seconds at multi-Gbit/s; the timestamps tell an old
+    //! segment from a new one even where its seqno would unwrap into the window.
+    bool stale(const TCPSegment &seg) const;
+
+    //! \brief handle an inbound segment (a stale() one is dropped)
     void segment_received(const TCPSegment &seg);
 
     //! \name "Output" interface for the reader
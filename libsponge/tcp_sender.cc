@@ -2,7 +2,11 @@
 
 #include "tcp_config.hh"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <random>
+#include <stdexcept>
 
 // Dummy implementation of a TCP sender
 
@@ -17,33 +21,384 @@ using namespace std;
 //! \param[in] capacity the capacity of the outgoing byte stream
 //! \param[in] retx_timeout the initial amount of time to wait before retransmitting the oldest outstanding segment
 //! \param[in] fixed_isn the Initial Sequence Number to use, if set (otherwise uses a random ISN)
-TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn)
+//! \param[in] double_mapped requests magic-ring storage for the outbound stream (see RingStorage)
+TCPSender::TCPSender(const size_t capacity,
+                     const uint16_t retx_timeout,
+                     const std::optional<WrappingInt32> fixed_isn,
+                     const bool double_mapped)
     : _isn(fixed_isn.value_or(WrappingInt32{random_device()()}))
     , _initial_retransmission_timeout{retx_timeout}
-    , _stream(capacity)
-    , _timer(retx_timeout) {}
+    , _stream(capacity, double_mapped)
+    , _rto(retx_timeout)
+    , _congestion_controller(std::make_unique<UnlimitedController>())
+    , _rtt(retx_timeout, TCPConfig::RTO_MIN_DFLT, TCPConfig::RTO_MAX_DFLT) {}
+
+//! \param[in] config supplies the parameters above, plus the congestion-control algorithm and the RTO policy
+TCPSender::TCPSender(const TCPConfig &config)
+    : TCPSender(config.send_capacity, config.rt_timeout, config.fixed_isn, config.double_mapped_buffers) {
+    _congestion_control = config.congestion_control;
+    _rtt = RTTEstimator(config.rt_timeout, config.rto_min, config.rto_max);
+    _adaptive_rto = config.adaptive_rto;
+    _fast_retransmit = config.fast_retransmit;
+    _sack = config.sack;
+    _rack = config.rack;
+    _configured_pacing_rate = config.pacing_rate;
+    _nagle = not config.nodelay;
+    _tso_size = config.tso_size;
+    set_mss(config.mss > 0 ? config.mss : TCPConfig::MAX_PAYLOAD_SIZE);
+}
+
+//! \param[in] wheel is the host's, which it advances, handing expired timers to timer_expired()
+//! \param[in] endpoint identifies the sender's timers on `wheel`
+TCPSender::TCPSender(const TCPConfig &config, TimingWheel &wheel, const uint64_t endpoint) : TCPSender(config) {
+    _timers = TCPTimers(wheel, endpoint);
+}
+
+void TCPSender::set_mss(const size_t mss) {
+    if (mss == 0) {
+        throw runtime_error("TCPSender::set_mss: mss must be positive");
+    }
+    _mss = mss;
+    _max_payload_size = _tso_size > 0 ? min(max(_tso_size, mss), max(TCPConfig::MAX_TSO_SIZE, mss)) : mss;
+    _congestion_controller = CongestionController::make(_congestion_control, mss);
+}
+
+void RTTEstimator::add_sample(const uint64_t rtt_ms) {
+    const auto r = static_cast<double>(rtt_ms);
+    if (not _srtt.has_value()) {
+        _srtt = r;
+        _rttvar = r / 2;
+        return;
+    }
+    // RTTVAR is updated first: it uses the SRTT from before this sample
+    _rttvar = (1 - BETA) * _rttvar + BETA * abs(_srtt.value() - r);
+    _srtt = (1 - ALPHA) * _srtt.value() + ALPHA * r;
+}
+
+uint32_t RTTEstimator::rto() const {
+    if (not _srtt.has_value()) {
+        return _initial_rto;
+    }
+    const auto rto = _srtt.value() + max(static_cast<double>(GRANULARITY_MS), 4 * _rttvar);
+    return static_cast<uint32_t>(clamp(ceil(rto), static_cast<double>(_min_rto), static_cast<double>(_max_rto)));
+}
+
+uint32_t RTTEstimator::backoff(const uint32_t rto) const {
+    return static_cast<uint32_t>(min<uint64_t>(2 * uint64_t{rto}, max(rto, _max_rto)));
+}
 
 size_t TCPSender::bytes_in_flight() const { return _bytes_in_flight; }
 
+size_t TCPSender::_send_window() const {
+    // if window size is 0, set it to 1; otherwise the congestion window may limit it further
+    if (_window_size == 0) {
+        return 1;
+    }
+    // in recovery, bytes that have left the network don't count against cwnd; with a scoreboard
+    // they are known (cwnd limits the pipe), otherwise they are estimated from duplicate ACKs
+    const auto cwnd = _congestion_controller->cwnd();
+    const auto left_network = _in_recovery && _scoreboard_recovery() ? _bytes_in_flight - _pipe() : _cwnd_inflation;
+    return min<size_t>(_window_size, cwnd + min(left_network, numeric_limits<size_t>::max() - cwnd));
+}
+
+uint64_t TCPSender::pacing_rate() const {
+    return _configured_pacing_rate > 0 ? _configured_pacing_rate : _congestion_controller->pacing_rate();
+}
+
+size_t TCPSender::_pacing_burst(const uint64_t rate) const {
+    return max<size_t>(2 * _mss, rate / 1000);
+}
+
+void TCPSender::_refill_pacing_tokens(const uint64_t rate) {
+    const auto burst = static_cast<double>(_pacing_burst(rate));
+    if (!_pacing_refill_ms.has_value()) {
+        _pacing_tokens = max(burst, static_cast<double>(PACING_INITIAL_QUANTUM * _mss));
+    } else {
+        const auto elapsed_ms = static_cast<double>(time_ms() - _pacing_refill_ms.value());
+        // never take away tokens, e.g. what is left of the initial quantum
+        const auto earned = static_cast<double>(rate) * elapsed_ms / 1000;
+        _pacing_tokens = max(_pacing_tokens, min(burst, _pacing_tokens + earned));
+    }
+    _pacing_refill_ms = time_ms();
+}
+
+optional<uint64_t> TCPSender::ms_until_release() const {
+    const auto rate = pacing_rate();
+    if (!_pacing_held || rate == 0) {
+        return nullopt;
+    }
+    // the bucket must be positive again: at least one millisecond, the clock's resolution
+    const auto owed = max(0.0, -_pacing_tokens);
+    return max<uint64_t>(1, static_cast<uint64_t>(ceil(owed * 1000 / static_cast<double>(rate))));
+}
+
+optional<uint64_t> TCPSender::ms_until_timeout() const {
+    using Kind = TCPTimers::Kind;
+    optional<uint64_t> earliest;
+    for (const auto timer : {Kind::Retransmission, Kind::Reordering, Kind::TailLossProbe, Kind::PacingRelease}) {
+        if (const auto ms = _timers.ms_until(timer)) {
+            earliest = min(earliest.value_or(ms.value()), ms.value());
+        }
+    }
+    return earliest;
+}
+
+void TCPSender::_retransmit(OutstandingSegment &out) {
+    // as in fill_window(), a copy of the header sharing the payload
+    _segments_out.push(out.segment);
+    _segments_out.back().set_ecn(IPv4Header::ECN::NotECT);  // a retransmission must not be marked (RFC 3168 6.1.5)
+    if (out.lost && !out.lost_retransmitted && !out.sacked) {
+        _pipe_bytes += out.segment.length_in_sequence_space();  // back in the network
+    }
+    out.retransmitted = true;
+    out.lost_retransmitted = out.lost;
+    _outstanding_seg.transmitted(out, time_ms());
+}
+
+void TCPSender::_update_scoreboard(const vector<TCPSackBlock> &blocks, const optional<uint32_t> ts_echo) {
+    for (const auto &block : blocks) {
+        const auto left = unwrap(block.left, _isn, _next_seqno);
+        const auto right = unwrap(block.right, _isn, _next_seqno);
+        if (left >= right || right > _next_seqno) {
+            continue;  // ignore blocks that make no sense
+        }
+        _sack_seen = true;
+        for (auto i = _outstanding_seg.find_starting_from(left);
+             i < _outstanding_seg.size() && _outstanding_seg[i].end() <= right;
+             ++i) {
+            auto &out = _outstanding_seg[i];
+            if (out.sacked) {
+                continue;
+            }
+            if (_rack_enabled()) {
+                _rack_update(out, ts_echo);
+            }
+            if (_in_pipe(out)) {
+                _pipe_bytes -= out.segment.length_in_sequence_space();
+            }
+            out.sacked = true;
+            _sacked_above += out.abs_seqno >= _loss_marked_to ? 1 : 0;
+        }
+    }
+
+    // the segments with DUP_ACK_THRESHOLD SACKed segments after them are lost; as SACKed segments are only
+    // added, they are a growing prefix, so marking picks up where it stopped
+    for (auto i = _outstanding_seg.find_starting_from(_loss_marked_to); i < _outstanding_seg.size(); ++i) {
+        auto &out = _outstanding_seg[i];
+        if (_sacked_above - (out.sacked ? 1 : 0) < DUP_ACK_THRESHOLD) {
+            break;
+        }
+        if (out.sacked) {
+            --_sacked_above;
+        } else if (!out.lost) {
+            _mark_lost(out);
+        }
+        _loss_marked_to = out.end();
+    }
+}
+
+void TCPSender::_mark_lost(OutstandingSegment &out) {
+    if (_in_pipe(out)) {
+        _pipe_bytes -= out.segment.length_in_sequence_space();
+    }
+    out.lost = true;
+    out.lost_retransmitted = false;
+    _retransmit_from = min(_retransmit_from, out.abs_seqno);
+    _lost_end = max(_lost_end, out.end());
+}
+
+//! \details The search resumes where the last one stopped: every segment marked lost since lies below
+//! _retransmit_from or is found on the way.
+OutstandingSegment *TCPSender::_next_lost() {
+    for (auto i = _outstanding_seg.find_starting_from(_retransmit_from);
+         i < _outstanding_seg.size() && _outstanding_seg[i].abs_seqno < _lost_end;
+         ++i) {
+        auto &out = _outstanding_seg[i];
+        if (out.lost && !out.lost_retransmitted && !out.sacked) {
+            _retransmit_from = out.abs_seqno;
+            return &out;
+        }
+    }
+    _retransmit_from = _lost_end;
+    return nullptr;
+}
+
+void TCPSender::_retransmit_lost() {
+    const auto cwnd = _congestion_controller->cwnd();
+    while (_pipe() < cwnd) {
+        auto *out = _next_lost();
+        if (out == nullptr) {
+            break;
+        }
+        _retransmit(*out);
+    }
+}
+
+void TCPSender::_enter_recovery(const bool scoreboard_has_losses) {
+    _in_recovery = true;
+    _recover = _next_seqno;
+    _congestion_controller->on_loss(_bytes_in_flight, time_ms());
+    _cwnd_inflation = DUP_ACK_THRESHOLD * _mss;
+    _tlp_end.reset();  // recovery takes over from a probe, and reduces cwnd only once
+    if (!scoreboard_has_losses && !_outstanding_seg.front().lost) {
+        _mark_lost(_outstanding_seg.front());
+    }
+    // the first lost segment is retransmitted at once, whatever the pipe
+    if (auto *out = _next_lost()) {
+        _retransmit(*out);
+    }
+}
+
+void TCPSender::_rack_update(const OutstandingSegment &out, const optional<uint32_t> ts_echo) {
+    const auto rtt = time_ms() - out.xmit_ms;
+    if (out.retransmitted) {
+        // the ACK may answer an earlier transmission, which would make the RTT look short
+        const bool echoes_earlier = ts_echo.has_value() &&
+                                    static_cast<int32_t>(ts_echo.value() - static_cast<uint32_t>(out.xmit_ms)) < 0;
+        if (echoes_earlier || rtt < _rack_min_rtt.value_or(0)) {
+            return;
+        }
+    }
+    _rack_min_rtt = min(_rack_min_rtt.value_or(rtt), rtt);
+
+    // a segment sent once, but delivered after a later one, was reordered rather than lost
+    if (!out.retransmitted && out.end() < _rack_fack) {
+        _rack_reordering_seen = true;
+    }
+    _rack_fack = max(_rack_fack, out.end());
+
+    if (out.xmit_ms > _rack_xmit_ms || (out.xmit_ms == _rack_xmit_ms && out.end() > _rack_end)) {
+        _rack_xmit_ms = out.xmit_ms;
+        _rack_end = out.end();
+        _rack_rtt = rtt;
+    }
+}
+
+//! \details Never shorter than the clock's granularity: round trips are counted in whole milliseconds,
+//! so a segment's may come out up to a millisecond shorter than that of the segment delivered after it.
+uint64_t TCPSender::_rack_reordering_window() const {
+    // until the path has shown reordering, a loss during recovery is not waited for
+    if (!_rack_reordering_seen && _in_recovery) {
+        return RTTEstimator::GRANULARITY_MS;
+    }
+    const auto srtt = static_cast<uint64_t>(_rtt.srtt_ms().value_or(0));
+    return max<uint64_t>(RTTEstimator::GRANULARITY_MS, min(_rack_min_rtt.value_or(0) / 4, srtt));
+}
+
+bool TCPSender::_rack_detect_loss() {
+    const auto reordering_window = _rack_reordering_window();
+    bool detected = false;
+    uint64_t timeout = 0;
+    _outstanding_seg.for_each_by_transmission([&](OutstandingSegment &out) {
+        if (out.xmit_ms > _rack_xmit_ms || (out.xmit_ms == _rack_xmit_ms && out.end() > _rack_end)) {
+            return false;  // sent after the newest delivered segment, as is everything after it
+        }
+        if (out.lost && !out.lost_retransmitted) {
+            return true;  // already waiting to be retransmitted
+        }
+        const auto deadline = out.xmit_ms + _rack_rtt + reordering_window;
+        if (deadline <= time_ms()) {
+            _mark_lost(out);  // even a retransmission can be lost again
+            detected = true;
+        } else {
+            timeout = max(timeout, deadline - time_ms());
+        }
+        return true;
+    });
+
+    if (timeout > 0) {
+        _timers.arm(TCPTimers::Kind::Reordering, timeout);
+    } else {
+        _timers.cancel(TCPTimers::Kind::Reordering);
+    }
+    return detected;
+}
+
+void TCPSender::_schedule_tlp() {
+    // one probe per tail, and only while nothing is known to be missing
+    if (!_rack_enabled() || _in_recovery || _sacked_outstanding || _tlp_end.has_value() ||
+        _outstanding_seg.empty() || _window_size == 0 || !_rtt.srtt_ms().has_value()) {
+        _timers.cancel(TCPTimers::Kind::TailLossProbe);
+        return;
+    }
+    auto pto = static_cast<uint32_t>(ceil(2 * _rtt.srtt_ms().value()));
+    if (_bytes_in_flight <= _mss) {
+        pto += TLP_MAX_ACK_DELAY;  // the ACK of a lone segment may be delayed
+    }
+    if (pto >= _rto) {
+        _timers.cancel(TCPTimers::Kind::TailLossProbe);  // the retransmission timer would go off first anyway
+        return;
+    }
+    _timers.arm(TCPTimers::Kind::TailLossProbe, pto);
+}
+
+void TCPSender::_send_tlp() {
+    // new data is sent whenever the window allows, so there is none to probe with: resend the last segment
+    _retransmit(_outstanding_seg[_outstanding_seg.size() - 1]);
+    _tlp_end = _next_seqno;
+    _timers.arm(TCPTimers::Kind::Retransmission, _rto);  // the retransmission timer runs from the probe
+}
+
+void TCPSender::_add_outstanding(TCPSegment &&segment, const uint64_t abs_seqno) {
+    auto &out = _outstanding_seg.push_back();  // a recycled slot: the copy for retransmission is moved in
+    out.abs_seqno = abs_seqno;
+    out.segment = std::move(segment);
+    out.sent_ms = time_ms();
+    out.delivered = _delivered;
+    out.delivered_ms = _delivered_ms;
+    out.first_sent_ms = _first_sent_ms;
+    out.app_limited = _app_limited_until > 0;
+    _outstanding_seg.transmitted(out, time_ms());
+    _pipe_bytes += out.segment.length_in_sequence_space();
+}
+
+bool TCPSender::_hold_partial_segment() const {
+    if (!_syn_flag || _stream.buffer_empty() || _stream.buffer_size() >= _mss || _stream.input_ended()) {
+        return false;
+    }
+    return _corked || (_nagle && _bytes_in_flight > 0);
+}
+
 void TCPSender::fill_window() {
-    uint16_t window_size = max(_window_size, static_cast<uint16_t>(1)); // if window size is 0, set it to 1
-    
+    const size_t window_size = _send_window();
+    const auto rate = pacing_rate();
+    if (rate > 0) {
+        _refill_pacing_tokens(rate);
+    }
+    _pacing_held = false;
+    bool sent_new_data = false;
+
     // send segment until the window is full or the stream is empty
     while (_bytes_in_flight < window_size) {
+        // when paced, a segment may overdraw the bucket, but only while it is positive
+        if (rate > 0 && _pacing_tokens <= 0) {
+            _pacing_held = !_stream.buffer_empty() || (_stream.eof() && !_fin_flag);
+            break;
+        }
+        if (_hold_partial_segment()) {
+            break;  // until it fills up, or (Nagle) the outstanding data is acknowledged
+        }
+
         TCPSegment seg;
-        
-        if (!_syn_flag) { // send SYN if not sent
+
+        if (!_syn_flag) {  // send SYN if not sent
             seg.header().syn = true;
+            seg.header().sack_permitted = _sack;
             _syn_flag = true;
         }
 
         // payload size is constrained by the segment size, buffer size, and the window size
         // No payload for SYN as initial window size is 1 and the flag already occupies 1 byte
-        auto payload_size = min(TCPConfig::MAX_PAYLOAD_SIZE, 
-                            min(window_size - _bytes_in_flight - (seg.header().syn ? 1 : 0) - (seg.header().fin ? 1 : 0), // available window size
-                             _stream.buffer_size()));
-        auto payload = _stream.read(payload_size); // read from the outbound byte stream
-        seg.payload() = Buffer(move(payload));
+        const auto available_window =
+            window_size - _bytes_in_flight - (seg.header().syn ? 1 : 0) - (seg.header().fin ? 1 : 0);
+        auto payload_size = min(_max_payload_size, min(available_window, _stream.buffer_size()));
+        // read from the outbound byte stream: bytes the application wrote as Buffers come out as slices
+        // of its storage (shared with the retransmission copy); only a payload spanning chunks is copied
+        const auto payload = _stream.read_buffers(payload_size);
+        seg.payload() = payload.buffers().size() <= 1 ? Buffer(payload) : Buffer(payload.concatenate());
+        if (_max_payload_size > _mss) {
+            seg.set_wire_mss(_mss);  // the adapter cuts a super-segment into wire segments of this size
+        }
 
         // stop sending by setting the FIN flag if the stream is empty
         // FIN can take payload
@@ -53,71 +408,299 @@ void TCPSender::fill_window() {
         }
 
         uint64_t seg_length = seg.length_in_sequence_space();
-        if (seg_length == 0) break; // stream is empty
+        if (seg_length == 0) {
+            break;  // stream is empty
+        }
+
+        // with ECN, data may be marked instead of dropped; the first new data after a reduction says so
+        if (_ecn && seg.payload().size() > 0) {
+            seg.set_ecn(IPv4Header::ECN::ECT0);
+            seg.header().cwr = _send_cwr;
+            _send_cwr = false;
+        }
+
+        // set the seqno of the segment and send it; stays outstanding until ACKed
+        seg.header().seqno = next_seqno();
+        if (_bytes_in_flight == 0) {  // sending after an idle period starts a new delivery-rate interval
+            _first_sent_ms = _delivered_ms = time_ms();
+        }
+        if (_sack_permitted && seg.needs_split()) {
+            // a super-segment is kept as its wire segments, so that a SACK block covering some of them
+            // marks just those, and only the rest is resent
+            uint64_t abs_seqno = _next_seqno;
+            for (auto &piece : seg.split(_mss)) {
+                const auto piece_length = piece.length_in_sequence_space();
+                _add_outstanding(std::move(piece), abs_seqno);
+                abs_seqno += piece_length;
+            }
+            _segments_out.push(std::move(seg));
+        } else {
+            _segments_out.push(seg);  // only the header is copied: the payload is shared with the outstanding copy
+            _add_outstanding(std::move(seg), _next_seqno);
+        }
+        sent_new_data = true;
 
-        seg.header().seqno = next_seqno(); // set the seqno of the segment and send it; stays outstanding until ACKed
-        _segments_out.push(seg);
-        _outstanding_seg.emplace(_next_seqno, std::move(seg));
+        if (!_timers.armed(TCPTimers::Kind::Retransmission)) {
+            _timers.arm(TCPTimers::Kind::Retransmission, _rto);  // start the timer
+        }
 
-        if (!_timer.is_running()) _timer.restart(); // start the timer, with time accumulated by tick
-        
-        _next_seqno += seg_length; // _next_seqno is absolute seqno, accumulated from 0
+        _next_seqno += seg_length;  // _next_seqno is absolute seqno, accumulated from 0
         _bytes_in_flight += seg_length;
+        _pacing_tokens -= static_cast<double>(seg_length);
+    }
+
+    // the window has room but there is nothing to send: rate samples until these bytes are delivered
+    // measure the application, not the network
+    if (_bytes_in_flight < window_size && _stream.buffer_empty()) {
+        _app_limited_until = max<uint64_t>(_delivered + _bytes_in_flight, 1);
+    }
+
+    if (sent_new_data) {
+        _schedule_tlp();  // the probe is timed from the newest segment
+    }
+
+    // wake up when the bucket has earned enough to release what pacing holds back
+    if (const auto release_ms = ms_until_release()) {
+        _timers.arm(TCPTimers::Kind::PacingRelease, release_ms.value());
+    } else {
+        _timers.cancel(TCPTimers::Kind::PacingRelease);
     }
 }
 
 //! \param ackno The remote receiver's ackno (acknowledgment number)
 //! \param window_size The remote receiver's advertised window size
-void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) {
+//! \param segment_length The sequence space the segment carrying the ACK occupies
+//! \param sack_blocks The SACK blocks the ACK carried
+//! \param ece Whether the ACK carried ECN-Echo
+void TCPSender::ack_received(const WrappingInt32 ackno,
+                             const size_t window_size,
+                             const size_t segment_length,
+                             const vector<TCPSackBlock> &sack_blocks,
+                             const optional<uint32_t> ts_echo,
+                             const bool ece) {
     auto abs_ackno = unwrap(ackno, _isn, next_seqno_absolute());
-    if (abs_ackno > next_seqno_absolute()) return; // the ACK is invalid as it acks data that doesn't exist, so discard it
-    
+    if (abs_ackno > next_seqno_absolute()) {
+        return;  // the ACK is invalid as it acks data that doesn't exist, so discard it
+    }
+
     // clear all outstanding segments acked by TCP receiver
     // a segment is considered outstanding from the time it is sent until an ACK covering all its data is received
-    bool is_outstanding_cleared = false;
-    while (!_outstanding_seg.empty()) {
-        auto &[abs_seqno, out_seg] = _outstanding_seg.front(); // no need to check elements other than the first one as ackno range is continuous
-        if (abs_seqno + out_seg.length_in_sequence_space() - 1 < abs_ackno) { // skip if already acked
-            is_outstanding_cleared = true;
-            _bytes_in_flight -= out_seg.length_in_sequence_space();
-            _outstanding_seg.pop();
-        } else { // stop when the first unacked segment is found
-            break;
-        } 
+    const auto acked = _outstanding_seg.count_ending_by(abs_ackno);
+    AckSample sample;
+    bool retransmission_acked = false;
+    for (size_t i = 0; i < acked; ++i) {
+        const auto &out = _outstanding_seg[i];
+        sample.acked_bytes += out.segment.length_in_sequence_space();
+        retransmission_acked |= out.retransmitted;
+        _pipe_bytes -= _in_pipe(out) ? out.segment.length_in_sequence_space() : 0;
+        _sacked_above -= out.sacked && out.abs_seqno >= _loss_marked_to ? 1 : 0;
+    }
+    // the wire segments of a super-segment are acknowledged one by one: count the acknowledged prefix too
+    size_t trimmed = 0;
+    if (_max_payload_size > _mss && acked < _outstanding_seg.size() &&
+        _outstanding_seg[acked].abs_seqno < abs_ackno) {
+        trimmed = abs_ackno - _outstanding_seg[acked].abs_seqno;
+        sample.acked_bytes += trimmed;
+        retransmission_acked |= _outstanding_seg[acked].retransmitted;
+    }
+    _bytes_in_flight -= sample.acked_bytes;
+
+    const bool is_outstanding_cleared = acked > 0 || trimmed > 0;
+    if (is_outstanding_cleared) {
+        // the most recently sent of the acked segments
+        const auto &newest = _outstanding_seg[trimmed > 0 ? acked : acked - 1];
+
+        // delivery rate over the longer of the send and ACK intervals of the newest acked segment
+        _delivered += sample.acked_bytes;
+        _delivered_ms = time_ms();
+        const auto interval = max(newest.sent_ms - newest.first_sent_ms, _delivered_ms - newest.delivered_ms);
+        _first_sent_ms = newest.sent_ms;
+        if (_app_limited_until > 0 && _delivered > _app_limited_until) {
+            _app_limited_until = 0;
+        }
+
+        sample.bytes_in_flight = _bytes_in_flight;
+        sample.now_ms = time_ms();
+        sample.delivered = _delivered;
+        sample.prior_delivered = newest.delivered;
+        sample.delivery_rate = interval > 0 ? (_delivered - newest.delivered) * 1000 / interval : 0;
+        sample.app_limited = newest.app_limited;
+        sample.in_recovery = _in_recovery;
+        sample.ece = _ecn && ece;
+        // Karn: if the ACK covers a retransmission, it may have been sent in response to it, so the newest
+        // segment's send time could be long before what the ACK actually measures. A timestamp echo says
+        // which transmission the ACK answers (an echo from the future is bogus, and ignored).
+        const auto echo_age = ts_echo.has_value() ? static_cast<uint32_t>(time_ms()) - ts_echo.value() : 0;
+        if (ts_echo.has_value() && echo_age <= time_ms()) {
+            sample.rtt_ms = echo_age;
+            _rtt.add_sample(echo_age);
+        } else if (!retransmission_acked) {
+            sample.rtt_ms = time_ms() - newest.sent_ms;
+            _rtt.add_sample(sample.rtt_ms.value());
+        }
+        if (_rack_enabled()) {
+            for (size_t i = 0; i < acked; ++i) {
+                _rack_update(_outstanding_seg[i], ts_echo);
+            }
+        }
+        if (trimmed > 0) {
+            auto &partial = _outstanding_seg[acked];
+            _pipe_bytes -= _in_pipe(partial) ? trimmed : 0;
+            partial.segment.payload().remove_prefix(trimmed);
+            partial.segment.header().seqno = partial.segment.header().seqno + static_cast<uint32_t>(trimmed);
+            partial.abs_seqno += trimmed;
+        }
+        _outstanding_seg.pop_front(acked);
+    }
+
+    if (!sack_blocks.empty()) {
+        _update_scoreboard(sack_blocks, ts_echo);
+    }
+    _sacked_outstanding = !sack_blocks.empty();
+
+    // the probe's episode ends once it is acknowledged; without a DSACK to say the original arrived too,
+    // the probe is taken to have repaired a loss, and cwnd is reduced as for one
+    if (_tlp_end.has_value() && abs_ackno >= _tlp_end.value()) {
+        if (!_in_recovery) {
+            _congestion_controller->on_loss(_bytes_in_flight + sample.acked_bytes, time_ms());
+        }
+        _tlp_end.reset();
     }
 
     // TCP only keeps one timer for the oldest outstanding segment
     // so only reset the timer if some outstanding segments are acked
     // otherwise, keep the timer running and resend until at least the oldest segment is acked
     if (is_outstanding_cleared) {
+        _duplicate_acks = 0;
+        if (_in_recovery && abs_ackno >= _recover) {
+            // a full ACK: everything outstanding at the loss has arrived
+            _in_recovery = false;
+            _cwnd_inflation = 0;
+        } else if (_in_recovery && !_outstanding_seg.empty() && !_scoreboard_recovery()) {
+            // a partial ACK: the next hole is lost too; deflate by what left the network, keep one new segment
+            _retransmit_oldest();
+            _cwnd_inflation = _cwnd_inflation - min(_cwnd_inflation, sample.acked_bytes) + _mss;
+        }
+
+        _congestion_controller->on_ack(sample);
         _consecutive_retransmission_cnt = 0;
-        _timer.set_rto(_initial_retransmission_timeout);
-        _timer.restart();
+        // an adaptive RTO keeps its backoff until an ACK gives a valid sample (Karn's algorithm)
+        if (!_adaptive_rto) {
+            _rto = _initial_retransmission_timeout;
+        } else if (sample.rtt_ms.has_value()) {
+            _rto = _rtt.rto();
+        }
+        _timers.arm(TCPTimers::Kind::Retransmission, _rto);
+    } else if (_fast_retransmit && segment_length == 0 && window_size == _window_size && !_outstanding_seg.empty() &&
+               abs_ackno == _outstanding_seg.front().abs_seqno) {
+        // a duplicate ACK: nothing new acknowledged, no data, no window update, and data outstanding
+        ++_duplicate_acks;
+        if (_in_recovery) {
+            _cwnd_inflation += _mss;  // each one means a segment has left the network
+        }
+    }
+
+    // enter recovery on the third duplicate ACK, or once the scoreboard (or RACK) deems a segment lost
+    // (only once per window: ACKs below _recover may be duplicates caused by the last recovery)
+    const bool rack_detected = _rack_enabled() && !_outstanding_seg.empty() && _rack_detect_loss();
+    if (_fast_retransmit && !_in_recovery && !_outstanding_seg.empty() && abs_ackno >= _recover &&
+        (_duplicate_acks >= DUP_ACK_THRESHOLD || _outstanding_seg.front().lost || rack_detected)) {
+        _enter_recovery(rack_detected);
+    }
+    if (_in_recovery && _scoreboard_recovery()) {
+        _retransmit_lost();
+    }
+
+    // ECE: the receiver saw congestion marks. Like a loss, they cost one reduction per window, and
+    // none while recovering from a loss of the same window; ECEs until the CWR gets through are ignored.
+    if (_ecn && ece && abs_ackno > max(_ecn_recover, _recover) && !_in_recovery) {
+        _congestion_controller->on_ecn(_bytes_in_flight, time_ms());
+        _ecn_recover = _next_seqno;
+        _send_cwr = true;
+        ++_ecn_reductions;
     }
 
     if (_bytes_in_flight == 0) {
-        _timer.stop();
+        _timers.cancel(TCPTimers::Kind::Retransmission);
+        _timers.cancel(TCPTimers::Kind::Reordering);
     }
 
     _window_size = window_size;
-    fill_window(); // continue sending on receiving ACK
+    if (is_outstanding_cleared || _sacked_outstanding || _in_recovery) {
+        _schedule_tlp();  // rearmed when the tail moves; stopped once losses are known
+    }
+    fill_window();  // continue sending on receiving ACK
 }
 
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
-// called every few milliseconds; track the passage of time by adding ms to the timer; retransmit if timeout
+// called every few milliseconds; the timers that go off are handled as of the end of the interval
 void TCPSender::tick(const size_t ms_since_last_tick) {
-    _timer.tick(ms_since_last_tick); // accumulate over time
-    
-    if (_timer.is_expired() && !_outstanding_seg.empty()) {
-        _segments_out.push(_outstanding_seg.front().second); // retransmit if timeout
-        
-        // exponential backoff and increment cnt, as long as the ACK is not received
-        // if window size is 0, it's not necessarily congestion, so no need to increment cnt and back off to avoid deadlock
-        if (_window_size > 0) {
-            ++_consecutive_retransmission_cnt;
-            _timer.set_rto(_timer.get_rto() * 2); 
+    _timers.advance(ms_since_last_tick, [&](const TCPTimers::Kind timer) { timer_expired(timer); });
+}
+
+void TCPSender::timer_expired(const TCPTimers::Kind timer) {
+    switch (timer) {
+        case TCPTimers::Kind::Retransmission:
+            _retransmission_timeout();
+            break;
+        case TCPTimers::Kind::Reordering:
+            _reordering_timeout();
+            break;
+        case TCPTimers::Kind::TailLossProbe:
+            // the tail has gone unacknowledged for two round trips; a probe elicits an ACK (with SACK blocks)
+            // that lets RACK find the losses, without waiting for the retransmission timer
+            if (!_outstanding_seg.empty()) {
+                _send_tlp();
+            }
+            break;
+        case TCPTimers::Kind::PacingRelease:
+            fill_window();  // release whatever the bucket has earned since
+            break;
+        case TCPTimers::Kind::DelayedAck:
+        case TCPTimers::Kind::Linger:
+            break;  // the TCPConnection's
+    }
+}
+
+void TCPSender::_retransmission_timeout() {
+    if (_outstanding_seg.empty()) {
+        return;
+    }
+    _retransmit_oldest();
+
+    // exponential backoff and increment cnt, as long as the ACK is not received
+    // if window size is 0, it's not necessarily congestion, so no need to increment cnt and back off to avoid deadlock
+    if (_window_size > 0) {
+        _congestion_controller->on_rto(_bytes_in_flight, time_ms());
+        _in_recovery = false;  // a timeout ends fast recovery, and duplicates of the old window are ignored
+        _cwnd_inflation = 0;
+        _duplicate_acks = 0;
+        _recover = _next_seqno;
+        // SACKed segments stay SACKed, but loss detection starts over
+        _pipe_bytes = _sacked_above = 0;
+        _loss_marked_to = _retransmit_from = _lost_end = 0;
+        for (size_t i = 0; i < _outstanding_seg.size(); ++i) {
+            auto &out = _outstanding_seg[i];
+            out.lost = out.lost_retransmitted = false;
+            _pipe_bytes += out.sacked ? 0 : out.segment.length_in_sequence_space();
+            _sacked_above += out.sacked ? 1 : 0;
         }
-        _timer.restart();
+        _timers.cancel(TCPTimers::Kind::Reordering);
+        _timers.cancel(TCPTimers::Kind::TailLossProbe);
+        _tlp_end.reset();
+        ++_consecutive_retransmission_cnt;
+        _rto = _adaptive_rto ? _rtt.backoff(_rto) : _rto * 2;
+    }
+    _timers.arm(TCPTimers::Kind::Retransmission, _rto);
+}
+
+void TCPSender::_reordering_timeout() {
+    const bool detected = _rack_detect_loss();
+    if (detected && _fast_retransmit && !_in_recovery && _outstanding_seg.front().abs_seqno >= _recover) {
+        _enter_recovery(true);
+    }
+    if (_in_recovery) {
+        _retransmit_lost();
     }
 }
 
@@ -126,6 +709,6 @@ unsigned int TCPSender::consecutive_retransmissions() const { return _consecutiv
 void TCPSender::send_empty_segment() {
     // Empty segment just for ACK
     TCPSegment seg;
-    seg.header().seqno = next_seqno(); // ackno is the seqno of the next byte expected
+    seg.header().seqno = next_seqno();  // ackno is the seqno of the next byte expected
     _segments_out.emplace(std::move(seg));
 }
\ No newline at end of file
@@ -2,35 +2,52 @@
 #define SPONGE_LIBSPONGE_TCP_SENDER_HH
 
 #include "byte_stream.hh"
+#include "congestion_controller.hh"
+#include "retransmission_queue.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
+#include "tcp_timers.hh"
 #include "wrapping_integers.hh"
 
 #include <cstdint>
 #include <deque>
 #include <functional>
+#include <memory>
+#include <optional>
 #include <queue>
 #include <utility>
+#include <vector>
 
-//! \brief The timer of TCP sender that starts after the segment is sent.
-class Timer {
-private:
-    uint32_t _cur_time = 0;
-    uint32_t _rto = 0; // retransmission timeout
-    bool _is_running = false;
-public:
-    Timer() = default;
-    Timer(const uint32_t rto) : _rto(rto) {}
-    void stop() { _is_running = false; }
-    void set_rto(const uint32_t rto) { _rto = rto; }
-    uint32_t get_rto() const { return _rto; }
-    void restart() { _is_running = true, _cur_time = 0; }
-    void tick(const size_t ms_since_last_tick) { // track the passage of time in ms
-        if (_is_running)
-            _cur_time += ms_since_last_tick; 
-    }
-    bool is_expired() const { return _is_running && _cur_time >= _rto; }
-    bool is_running() const { return _is_running; }
+//! \brief Smoothed round-trip time and variance, and the retransmission timeout they give (RFC 6298)
+class RTTEstimator {
+  private:
+    uint32_t _initial_rto;
+    uint32_t _min_rto;
+    uint32_t _max_rto;
+    std::optional<double> _srtt{};  //!< Smoothed RTT in milliseconds, once there is a sample
+    double _rttvar = 0;             //!< RTT variation in milliseconds
+
+  public:
+    static constexpr double ALPHA = 1.0 / 8;  //!< Gain of the SRTT filter
+    static constexpr double BETA = 1.0 / 4;   //!< Gain of the RTTVAR filter
+    static constexpr uint32_t GRANULARITY_MS = 1;  //!< The clock granularity G: tick() counts milliseconds
+
+    RTTEstimator(const uint32_t initial_rto, const uint32_t min_rto, const uint32_t max_rto)
+        : _initial_rto(initial_rto), _min_rto(min_rto), _max_rto(max_rto) {}
+
+    //! Take a round-trip measurement of a segment that was never retransmitted (Karn's algorithm), or one
+    //! timed by the timestamps option
+    void add_sample(const uint64_t rtt_ms);
+
+    //! \brief The timeout to arm the retransmission timer with
+    //! \returns SRTT + max(G, 4 * RTTVAR) within [min_rto, max_rto], or the initial RTO before any sample
+    uint32_t rto() const;
+
+    //! Double `rto` for a retransmission, but no further than the maximum
+    uint32_t backoff(const uint32_t rto) const;
+
+    std::optional<double> srtt_ms() const { return _srtt; }
+    double rttvar_ms() const { return _rttvar; }
 };
 
 //! \brief The "sender" part of a TCP implementation.
@@ -56,11 +73,14 @@ class TCPSender {
     //! the (absolute) sequence number for the next byte to be sent
     uint64_t _next_seqno{0};
 
-    //! The timer for retransmission
-    Timer _timer;
+    //! The retransmission timeout to arm the timer with, including any backoff
+    uint32_t _rto;
 
-    //! The queue of outstanding segments; Use queue to make sure that the first element is the oldest
-    std::queue<std::pair<uint64_t, TCPSegment>> _outstanding_seg{};
+    //! The retransmission, reordering, probe and pacing timers (and the connection's, if there is one)
+    TCPTimers _timers{};
+
+    //! The outstanding segments, oldest first
+    RetransmissionQueue _outstanding_seg{};
 
     //! The number of consecutive retransmissions of the same segment
     uint32_t _consecutive_retransmission_cnt = 0;
@@ -68,19 +88,196 @@ class TCPSender {
     //! The number of bytes sent but not yet acknowledged, including SYN and FIN
     size_t _bytes_in_flight = 0;
 
-    //! Window size, 1 by default
-    uint16_t _window_size = 1;
+    //! The receiver's window in bytes (its advertisement after window scaling), 1 by default
+    size_t _window_size = 1;
 
     //! Flags for SYN and FIN
     bool _syn_flag = false;
     bool _fin_flag = false;
 
+    //! The congestion-control policy; limits the bytes in flight to its cwnd
+    std::unique_ptr<CongestionController> _congestion_controller;
+
+    //! Round-trip time measurements
+    RTTEstimator _rtt;
+
+    //! Arm the timer with the estimator's RTO; otherwise always with the initial timeout
+    bool _adaptive_rto = false;
+
+    //! \name Fast retransmit and NewReno fast recovery (RFC 5681, RFC 6582)
+    //!@{
+    bool _fast_retransmit = false;   //!< Whether duplicate ACKs are acted on at all
+    unsigned _duplicate_acks = 0;    //!< Duplicate ACKs since new data was last acknowledged
+    bool _in_recovery = false;
+    uint64_t _recover = 0;           //!< Recovery ends once everything below this is acknowledged
+    size_t _cwnd_inflation = 0;      //!< Segments that left the network during recovery (one MSS per duplicate ACK)
+    //!@}
+
+    //! \name Selective acknowledgments (RFC 2018, RFC 6675)
+    //!@{
+    bool _sack = false;       //!< Offer SACK on our SYN
+    bool _sack_seen = false;  //!< The receiver has sent SACK blocks, so recovery is driven by the scoreboard
+    bool _sack_permitted = false;      //!< Both SYNs offered SACK
+    bool _sacked_outstanding = false;  //!< The last ACK carried SACK blocks: the receiver holds data past a hole
+    size_t _pipe_bytes = 0;            //!< _pipe(), kept up to date as segments are sent, marked and acknowledged
+    uint64_t _loss_marked_to = 0;      //!< Segments below this have had DUP_ACK_THRESHOLD SACKed segments after them
+    size_t _sacked_above = 0;          //!< SACKed outstanding segments at or above _loss_marked_to
+    uint64_t _retransmit_from = 0;     //!< No lost segment below this is waiting to be retransmitted
+    uint64_t _lost_end = 0;            //!< Just past the highest segment marked lost
+    //!@}
+
+    //! \name RACK-TLP: time-based loss detection and tail loss probes (RFC 8985)
+    //!@{
+    bool _rack = false;                         //!< TCPConfig::rack; in effect once SACK is permitted
+    uint64_t _rack_xmit_ms = 0;                 //!< RACK.xmit_ts: last send time of the newest delivered segment
+    uint64_t _rack_end = 0;                     //!< RACK.end_seq: that segment's end
+    uint64_t _rack_rtt = 0;                     //!< RACK.rtt: the round trip it measured
+    std::optional<uint64_t> _rack_min_rtt{};    //!< Shortest round trip RACK has measured
+    uint64_t _rack_fack = 0;                    //!< Highest end of a delivered segment
+    bool _rack_reordering_seen = false;         //!< A segment was delivered after one sent later in sequence
+    std::optional<uint64_t> _tlp_end{};         //!< TLP.end_seq: set while a probe is unanswered
+    //!@}
+
+    //! \name Explicit congestion notification (RFC 3168)
+    //!@{
+    bool _ecn = false;           //!< Both SYNs set up ECN: new data is sent ECT, and ECE is acted on
+    uint64_t _ecn_recover = 0;   //!< ECE is taken as new congestion only on ACKs beyond this (once per window)
+    bool _send_cwr = false;      //!< The next new data segment carries CWR: cwnd was reduced
+    uint64_t _ecn_reductions = 0;  //!< Reductions for ECE
+    //!@}
+
+    //! \name Segment sizes
+    //!@{
+    size_t _mss = TCPConfig::MAX_PAYLOAD_SIZE;  //!< Largest payload of a wire segment
+    size_t _tso_size = 0;                       //!< TCPConfig::tso_size
+    size_t _max_payload_size = TCPConfig::MAX_PAYLOAD_SIZE;  //!< The MSS, or a super-segment's payload with TSO
+    CongestionController::Algorithm _congestion_control = CongestionController::Algorithm::None;
+    //!@}
+
+    //! \name Coalescing of small writes
+    //!@{
+    bool _nagle = false;   //!< Hold a partial segment while data is unacknowledged (RFC 896)
+    bool _corked = false;  //!< Hold partial segments until uncorked
+    //!@}
+
+    //! \brief Whether to hold back the partial segment at the head of the stream
+    //! \details Nagle's algorithm and cork never delay a full segment, a SYN, or the end of the stream.
+    bool _hold_partial_segment() const;
+
+    //! \name Pacing: a token bucket refilled at the pacing rate
+    //!@{
+    uint64_t _configured_pacing_rate = 0;         //!< Bytes per second, or 0 to follow the controller
+    double _pacing_tokens = 0;                    //!< Bytes that may be released now (negative: owed)
+    std::optional<uint64_t> _pacing_refill_ms{};  //!< When the bucket was last refilled (empty: never)
+    bool _pacing_held = false;                    //!< Pacing is holding back data the window would allow
+    //!@}
+
+    //! \name Delivery-rate sampling
+    //!@{
+    uint64_t _delivered = 0;           //!< Bytes (sequence space) acknowledged so far
+    uint64_t _delivered_ms = 0;        //!< When _delivered last grew
+    uint64_t _first_sent_ms = 0;       //!< Send time of the segment whose ACK last grew _delivered
+    uint64_t _app_limited_until = 0;   //!< Samples are application-limited until _delivered passes this (0: not)
+    //!@}
+
+    //! \brief Most bytes the bucket holds: two segments, or a millisecond at `rate` if that is more
+    //! \details The clock counts milliseconds, so a bucket smaller than a millisecond's worth would cap the rate
+    size_t _pacing_burst(const uint64_t rate) const;
+
+    //! Add the tokens earned since the last refill
+    void _refill_pacing_tokens(const uint64_t rate);
+
+    //! Add `segment`, just sent, which starts at `abs_seqno`, to the outstanding segments
+    void _add_outstanding(TCPSegment &&segment, const uint64_t abs_seqno);
+
+    //! Send an outstanding segment again
+    void _retransmit(OutstandingSegment &out);
+
+    //! Send the oldest outstanding segment again
+    void _retransmit_oldest() { _retransmit(_outstanding_seg.front()); }
+
+    //! The retransmission timer expired: resend the oldest segment, and back off
+    void _retransmission_timeout();
+
+    //! RACK's reordering timer expired: segments within their reordering window at the last ACK may have
+    //! outlasted it
+    void _reordering_timeout();
+
+    //! Mark the outstanding segments covered by `blocks` as SACKed, and those with
+    //! DUP_ACK_THRESHOLD SACKed segments after them as lost
+    void _update_scoreboard(const std::vector<TCPSackBlock> &blocks, const std::optional<uint32_t> ts_echo);
+
+    //! \brief The bytes estimated to be in the network (RFC 6675's "pipe")
+    //! \details Neither SACKed segments nor lost ones that have not been retransmitted count.
+    size_t _pipe() const { return _pipe_bytes; }
+
+    //! Whether `out` counts in the pipe
+    static bool _in_pipe(const OutstandingSegment &out) {
+        return !out.sacked && (!out.lost || out.lost_retransmitted);
+    }
+
+    //! Mark `out` lost (again, if it has been retransmitted since it was last marked)
+    void _mark_lost(OutstandingSegment &out);
+
+    //! The oldest lost segment waiting to be retransmitted, or nullptr if there is none
+    OutstandingSegment *_next_lost();
+
+    //! During SACK recovery, retransmit lost segments, oldest first, while the pipe is below cwnd
+    void _retransmit_lost();
+
+    //! The sender's window: the receiver's, limited by cwnd (inflated during fast recovery)
+    size_t _send_window() const;
+
+    //! Enter fast recovery: reduce cwnd, and retransmit the oldest segment unless the scoreboard already
+    //! knows which segments are lost
+    void _enter_recovery(const bool scoreboard_has_losses);
+
+    //! Whether RACK-TLP is in effect
+    bool _rack_enabled() const { return _rack && _sack_permitted; }
+
+    //! Recovery is driven by the scoreboard: the receiver has sent SACK blocks, or RACK marks losses
+    bool _scoreboard_recovery() const { return _sack_seen || _rack_enabled(); }
+
+    //! RACK_update(): take a newly delivered (acknowledged or SACKed) segment into account
+    void _rack_update(const OutstandingSegment &out, const std::optional<uint32_t> ts_echo);
+
+    //! RACK's reordering window, in milliseconds
+    uint64_t _rack_reordering_window() const;
+
+    //! \brief RACK_detect_loss(): mark the segments sent a reordering window and a round trip before the newest
+    //! delivered one as lost, and arm the reordering timer for the rest
+    //! \returns whether any segment was newly marked lost
+    bool _rack_detect_loss();
+
+    //! Arm the probe timeout if a tail loss probe may be sent, or stop it
+    void _schedule_tlp();
+
+    //! The PTO expired: retransmit the last segment to elicit an ACK that reveals the losses at the tail
+    void _send_tlp();
 
   public:
-    //! Initialize a TCPSender
+    //! Duplicate ACKs that trigger a fast retransmit
+    static constexpr unsigned DUP_ACK_THRESHOLD = 3;
+
+    //! \brief Allowance in the probe timeout for a delayed ACK of a single segment (RFC 8985's WCDelAckT)
+    //! \details The RFC's 200 ms would exceed most adaptive RTOs; this is the delayed-ACK timer of our own receiver.
+    static constexpr uint32_t TLP_MAX_ACK_DELAY = TCPConfig::DELAYED_ACK_TIMEOUT_DFLT;
+
+    //! Segments a paced connection may send at once before it is first throttled (its initial window)
+    static constexpr size_t PACING_INITIAL_QUANTUM = 10;
+
+    //! Initialize a TCPSender with flow control only (no congestion control)
     TCPSender(const size_t capacity = TCPConfig::DEFAULT_CAPACITY,
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
-              const std::optional<WrappingInt32> fixed_isn = {});
+              const std::optional<WrappingInt32> fixed_isn = {},
+              const bool double_mapped = false);
+
+    //! Initialize a TCPSender from a full configuration, including its congestion control
+    explicit TCPSender(const TCPConfig &config);
+
+    //! \brief Initialize a TCPSender whose timers are on `wheel`, which the host shares and advances
+    //! \param endpoint identifies the sender's timers on the wheel (see TCPTimers)
+    TCPSender(const TCPConfig &config, TimingWheel &wheel, const uint64_t endpoint);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -92,7 +289,19 @@ class TCPSender {
     //!@{
 
     //! \brief A new acknowledgment was received
-    void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    //! \param window_size is the receiver's window in bytes: the advertised `win`, scaled if scaling is in effect
+    //! \param segment_length is the sequence space of the segment carrying the ACK: only ACKs of
+    //! empty segments count as duplicates
+    //! \param sack_blocks are the SACK blocks the ACK carried
+    //! \param ts_echo is the ACK's TSecr, if timestamps are in use: the time_ms() at which the data it
+    //! acknowledges was sent, which times even an ACK of a retransmission (RFC 7323)
+    //! \param ece is whether the ACK carried ECN-Echo (ignored unless ECN is in use)
+    void ack_received(const WrappingInt32 ackno,
+                      const size_t window_size,
+                      const size_t segment_length = 0,
+                      const std::vector<TCPSackBlock> &sack_blocks = {},
+                      const std::optional<uint32_t> ts_echo = std::nullopt,
+                      const bool ece = false);
 
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
@@ -101,7 +310,13 @@ class TCPSender {
     void fill_window();
 
     //! \brief Notifies the TCPSender of the passage of time
+    //! \details Advances the sender's own wheel, and handles the timers that go off; a sender on a
+    //! shared wheel throws, as the host advances it.
     void tick(const size_t ms_since_last_tick);
+
+    //! \brief Timer `timer` went off, and TCPTimers::fired() says it is due (the TCPConnection's own
+    //! timers are ignored)
+    void timer_expired(const TCPTimers::Kind timer);
     //!@}
 
     //! \name Accessors
@@ -115,6 +330,77 @@ class TCPSender {
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const;
 
+    //! \name Coalescing of small writes
+    //! These only change what the next fill_window() sends.
+    //!@{
+
+    //! Send partial segments at once (true), or hold one while data is unacknowledged (Nagle's algorithm)
+    void set_nodelay(const bool nodelay) { _nagle = not nodelay; }
+    bool nodelay() const { return not _nagle; }
+
+    //! While corked, only full segments (and the end of the stream) are sent
+    void set_corked(const bool corked) { _corked = corked; }
+    bool corked() const { return _corked; }
+    //!@}
+
+    //! \brief The rate at which new segments are released, in bytes per second (0: unpaced)
+    uint64_t pacing_rate() const;
+
+    //! \brief Milliseconds until pacing releases data it is holding back
+    //! \returns empty if pacing is not holding anything back; call tick() by then
+    std::optional<uint64_t> ms_until_release() const;
+
+    //! \brief Milliseconds until the earliest of the sender's timers goes off (retransmission, RACK's
+    //! reordering timer, the probe timeout, or pacing's release)
+    //! \returns empty if none is armed; until then, tick() only moves the clock
+    std::optional<uint64_t> ms_until_timeout() const;
+
+    //! \brief The timers, on the sender's own wheel or the host's; the TCPConnection arms its own on them too
+    TCPTimers &timers() { return _timers; }
+    const TCPTimers &timers() const { return _timers; }
+
+    //! \brief The receiver's window, in bytes, as of the last ACK
+    size_t window_size() const { return _window_size; }
+
+    //! \brief Largest payload of a wire segment (see TCPConfig::mss)
+    size_t mss() const { return _mss; }
+
+    //! \brief Whether both SYNs offered SACK; RACK-TLP depends on it
+    void set_sack_permitted(const bool permitted) { _sack_permitted = permitted; }
+
+    //! \brief Whether both SYNs set up ECN; then new data is sent ECN-capable, and ECE reduces cwnd
+    void set_ecn(const bool ecn) { _ecn = ecn; }
+
+    //! \brief Times cwnd was reduced because the receiver echoed congestion marks
+    uint64_t ecn_reductions() const { return _ecn_reductions; }
+
+    //! \brief Use `mss` as the segment size, once the handshake has settled it (RFC 6691)
+    //! \details The congestion controller starts over, with its initial window counted in the new size;
+    //! so this is meant for before any data has been sent.
+    void set_mss(const size_t mss);
+
+    //! \brief The sender's clock, the wheel's (the TSval of a timestamps option): with a wheel of its own,
+    //! the total milliseconds passed to tick()
+    uint64_t time_ms() const { return _timers.now_ms(); }
+
+    //! \brief Whether the sender is in fast recovery
+    bool in_fast_recovery() const { return _in_recovery; }
+
+    //! \brief Duplicate ACKs received since new data was last acknowledged
+    unsigned duplicate_acks() const { return _duplicate_acks; }
+
+    //! \brief Whether a tail loss probe has been sent and not yet answered
+    bool tlp_in_flight() const { return _tlp_end.has_value(); }
+
+    //! \brief The round-trip time estimates
+    const RTTEstimator &rtt_estimator() const { return _rtt; }
+
+    //! \brief The retransmission timeout currently armed, in milliseconds (including any backoff)
+    uint32_t rto_ms() const { return _rto; }
+
+    //! \brief The congestion-control policy in use
+    const CongestionController &congestion_controller() const { return *_congestion_controller; }
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
@@ -0,0 +1,90 @@
+#include "tcp_timers.hh"
+
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+TCPTimers::TCPTimers() : _own_wheel(make_unique<TimingWheel>()), _wheel(_own_wheel.get()) {}
+
+TCPTimers::TCPTimers(TimingWheel &wheel, const uint64_t endpoint) : _wheel(&wheel), _endpoint(endpoint) {
+    if (endpoint >> KIND_SHIFT != 0) {
+        throw runtime_error("TCPTimers: endpoint key too large");
+    }
+}
+
+TCPTimers::TCPTimers(TCPTimers &&other) noexcept
+    : _own_wheel(move(other._own_wheel))
+    , _wheel(exchange(other._wheel, nullptr))
+    , _endpoint(other._endpoint)
+    , _ids(other._ids)
+    , _deadlines_ms(other._deadlines_ms)
+    , _due(other._due) {}
+
+TCPTimers &TCPTimers::operator=(TCPTimers &&other) noexcept {
+    if (this != &other) {
+        cancel_all();
+        _own_wheel = move(other._own_wheel);
+        _wheel = exchange(other._wheel, nullptr);
+        _endpoint = other._endpoint;
+        _ids = other._ids;
+        _deadlines_ms = other._deadlines_ms;
+        _due = other._due;
+    }
+    return *this;
+}
+
+void TCPTimers::arm(const Kind kind, const uint64_t delay_ms) {
+    if (_wheel == nullptr) {
+        return;
+    }
+    const auto delay = max<uint64_t>(delay_ms, 1);
+    _deadlines_ms[static_cast<size_t>(kind)] = _wheel->now_ms() + delay;
+    _due[static_cast<size_t>(kind)] = false;
+    // moved later, it stays filed where it is
+    if (!_wheel->armed(_id(kind)) || _wheel->ms_until(_id(kind)) > delay) {
+        _id(kind) = _wheel->rearm(_id(kind), delay, key(_endpoint, kind));
+    }
+}
+
+bool TCPTimers::fired(const Kind kind) {
+    if (_wheel == nullptr || _wheel->armed(_id(kind))) {
+        return false;  // cancelled or rearmed since
+    }
+    if (_wheel->now_ms() < _deadline_ms(kind)) {
+        _id(kind) = _wheel->arm(_deadline_ms(kind) - _wheel->now_ms(), key(_endpoint, kind));
+        return false;
+    }
+    return true;
+}
+
+void TCPTimers::cancel(const Kind kind) {
+    if (_wheel == nullptr) {
+        return;
+    }
+    _wheel->cancel(_id(kind));
+    _due[static_cast<size_t>(kind)] = false;
+}
+
+void TCPTimers::cancel_all() {
+    for (size_t i = 0; i < KINDS; ++i) {
+        cancel(static_cast<Kind>(i));
+    }
+}
+
+optional<uint64_t> TCPTimers::ms_until(const Kind kind) const {
+    if (!armed(kind)) {
+        return nullopt;
+    }
+    return _deadline_ms(kind) - _wheel->now_ms();
+}
+
+optional<uint64_t> TCPTimers::ms_until_next() const {
+    optional<uint64_t> earliest;
+    for (size_t i = 0; i < KINDS; ++i) {
+        if (const auto ms = ms_until(static_cast<Kind>(i))) {
+            earliest = min(earliest.value_or(ms.value()), ms.value());
+        }
+    }
+    return earliest;
+}
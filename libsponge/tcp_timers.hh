@@ -0,0 +1,130 @@
+#ifndef SPONGE_LIBSPONGE_TCP_TIMERS_HH
+#define SPONGE_LIBSPONGE_TCP_TIMERS_HH
+
+#include "timing_wheel.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+//! \brief The timers of one TCP endpoint, armed on a TimingWheel that is either its own or shared by
+//! the endpoints of a host
+//!
+//! With its own wheel, the endpoint keeps time through tick(), which advances the wheel. A host with many
+//! connections instead owns one wheel, gives each connection a key of its own, and advances the wheel
+//! itself: only the connections whose timers come due are called (see TCPConnection::timer_expired).
+//! Timer `kind` of the endpoint with key `k` is filed under key(k, kind).
+//!
+//! The retransmission timer is pushed back on every ACK, so a timer moved later stays filed where it is,
+//! with the new deadline noted: when it goes off early, fired() refiles it for the rest.
+class TCPTimers {
+  public:
+    //! What a timer is for
+    enum class Kind : uint8_t {
+        Retransmission,  //!< The sender's retransmission timeout (RTO)
+        Reordering,      //!< RACK's reordering window
+        TailLossProbe,   //!< The probe timeout (PTO) of RACK-TLP
+        PacingRelease,   //!< Pacing may release the data it holds back
+        DelayedAck,      //!< A delayed ACK is due
+        Linger,          //!< The end of TIME_WAIT
+    };
+    static constexpr size_t KINDS = 6;
+
+    //! Keys of endpoints on a shared wheel must fit below the kind
+    static constexpr unsigned KIND_SHIFT = 56;
+
+    //! The key under which timer `kind` of the endpoint with key `endpoint` is filed
+    static uint64_t key(const uint64_t endpoint, const Kind kind) {
+        return static_cast<uint64_t>(kind) << KIND_SHIFT | endpoint;
+    }
+
+    //! The endpoint whose timer is filed under `key`
+    static uint64_t endpoint_of(const uint64_t key) { return key & ((uint64_t{1} << KIND_SHIFT) - 1); }
+
+    //! What the timer filed under `key` is for
+    static Kind kind_of(const uint64_t key) { return static_cast<Kind>(key >> KIND_SHIFT); }
+
+  private:
+    std::unique_ptr<TimingWheel> _own_wheel{};  //!< Set unless the wheel is shared
+    TimingWheel *_wheel;                        //!< Null once moved from
+    uint64_t _endpoint = 0;
+    std::array<TimingWheel::TimerId, KINDS> _ids{};
+    std::array<uint64_t, KINDS> _deadlines_ms{};  //!< When each armed timer is due (it may be filed earlier)
+    std::array<bool, KINDS> _due{};  //!< Went off during tick()'s advance, and not since armed or cancelled
+
+    TimingWheel::TimerId &_id(const Kind kind) { return _ids[static_cast<size_t>(kind)]; }
+    TimingWheel::TimerId _id(const Kind kind) const { return _ids[static_cast<size_t>(kind)]; }
+    uint64_t _deadline_ms(const Kind kind) const { return _deadlines_ms[static_cast<size_t>(kind)]; }
+
+  public:
+    //! Timers on a wheel of their own, advanced by advance()
+    TCPTimers();
+
+    //! \brief Timers on a wheel the host shares among its endpoints and advances
+    //! \param endpoint identifies this endpoint's timers; it must be below 2^KIND_SHIFT
+    TCPTimers(TimingWheel &wheel, const uint64_t endpoint);
+
+    //! \name Moving leaves the source with no wheel: nothing is armed, and its clock reads 0
+    //!@{
+    TCPTimers(TCPTimers &&other) noexcept;
+    TCPTimers &operator=(TCPTimers &&other) noexcept;
+    TCPTimers(const TCPTimers &other) = delete;
+    TCPTimers &operator=(const TCPTimers &other) = delete;
+    //!@}
+
+    //! Cancels the timers still armed, so that a shared wheel never hands back the key of a gone endpoint
+    ~TCPTimers() { cancel_all(); }
+
+    //! Arm timer `kind` to go off `delay_ms` from now (at least 1 ms), in place of any armed one
+    void arm(const Kind kind, const uint64_t delay_ms);
+
+    //! Stop timer `kind`, if it is armed
+    void cancel(const Kind kind);
+
+    //! \brief Whether timer `kind`, which has just gone off on the wheel, is due
+    //! \returns false if it has been moved later, and so is refiled for the rest of its delay (or if it
+    //! has been armed again or cancelled since)
+    bool fired(const Kind kind);
+
+    //! Stop every timer
+    void cancel_all();
+
+    //! Whether timer `kind` is armed
+    bool armed(const Kind kind) const { return _wheel != nullptr && _wheel->armed(_id(kind)); }
+
+    //! Milliseconds until timer `kind` goes off; empty if it is not armed
+    std::optional<uint64_t> ms_until(const Kind kind) const;
+
+    //! Milliseconds until the earliest armed timer goes off; empty if none is armed
+    std::optional<uint64_t> ms_until_next() const;
+
+    //! The wheel's clock, in milliseconds
+    uint64_t now_ms() const { return _wheel != nullptr ? _wheel->now_ms() : 0; }
+
+    //! Whether the wheel is shared, so that the host rather than advance() moves it
+    bool shared() const { return _own_wheel == nullptr; }
+
+    //! \brief Move an own wheel forward by `ms`, then hand each timer that went off to `visit`, in the
+    //! order of Kind, as if it had gone off at the end of the interval
+    //! \details The timers are only handled once the clock has reached the end, so a timer rearmed by
+    //! its own visit goes off at most once per call, as with a clock that only moves in ticks. A timer
+    //! that an earlier visit rearms or cancels is skipped, as is one that was moved later (see fired()).
+    template <typename Visit>
+    void advance(const uint64_t ms, Visit &&visit) {
+        if (shared()) {
+            throw std::runtime_error("TCPTimers::advance: a shared wheel is advanced by its host");
+        }
+        _wheel->advance(ms, [&](const uint64_t key) { _due[static_cast<size_t>(kind_of(key))] = true; });
+        for (size_t i = 0; i < KINDS; ++i) {
+            if (std::exchange(_due[i], false) && fired(static_cast<Kind>(i))) {
+                visit(static_cast<Kind>(i));
+            }
+        }
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_TIMERS_HH
@@ -7,11 +7,32 @@ void Buffer::remove_prefix(const size_t n) {
         throw out_of_range("Buffer::remove_prefix");
     }
     _starting_offset += n;
-    if (_storage and _starting_offset == _storage->size()) {
+    _size -= n;
+    if (_storage and _size == 0) {
         _storage.reset();
     }
 }
 
+void Buffer::remove_suffix(const size_t n) {
+    if (n > str().size()) {
+        throw out_of_range("Buffer::remove_suffix");
+    }
+    _size -= n;
+    if (_storage and _size == 0) {
+        _storage.reset();
+    }
+}
+
+Buffer Buffer::substr(const size_t pos, const size_t len) const {
+    if (pos > size()) {
+        throw out_of_range("Buffer::substr");
+    }
+    Buffer ret{*this};
+    ret.remove_prefix(pos);
+    ret.remove_suffix(ret.size() - min(len, ret.size()));
+    return ret;
+}
+
 void BufferList::append(const BufferList &other) {
     for (const auto &buf : other._buffers) {
         _buffers.push_back(buf);
@@ -2,6 +2,7 @@
 #define SPONGE_LIBSPONGE_BUFFER_HH
 
 #include <algorithm>
+#include <array>
 #include <deque>
 #include <memory>
 #include <numeric>
@@ -11,17 +12,20 @@
 #include <sys/uio.h>
 #include <vector>
 
-//! \brief A reference-counted read-only string that can discard bytes from the front
+//! \brief A reference-counted read-only string that can discard bytes from either end
+//! \note Copies and slices share the same storage, so slicing never copies the bytes.
 class Buffer {
   private:
     std::shared_ptr<std::string> _storage{};
     size_t _starting_offset{};
+    size_t _size{};  //!< Bytes visible from `_starting_offset`
 
   public:
     Buffer() = default;
 
     //! \brief Construct by taking ownership of a string
-    Buffer(std::string &&str) noexcept : _storage(std::make_shared<std::string>(std::move(str))) {}
+    Buffer(std::string &&str) noexcept
+        : _storage(std::make_shared<std::string>(std::move(str))), _size(_storage->size()) {}
 
     //! \name Expose contents as a std::string_view
     //!@{
@@ -29,7 +33,7 @@ class Buffer {
         if (not _storage) {
             return {};
         }
-        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset};
+        return {_storage->data() + _starting_offset, _size};
     }
 
     operator std::string_view() const { return str(); }
@@ -44,9 +48,19 @@ class Buffer {
     //! \brief Make a copy to a new std::string
     std::string copy() const { return std::string(str()); }
 
+    //! \brief Size of the storage this Buffer keeps alive, which may be far more than size()
+    size_t storage_size() const { return _storage ? _storage->size() : 0; }
+
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
     void remove_prefix(const size_t n);
+
+    //! \brief Discard the last `n` bytes of the string (does not require a copy or move)
+    void remove_suffix(const size_t n);
+
+    //! \brief A Buffer of (up to) `len` bytes starting at `pos`, sharing this Buffer's storage
+    //! \note Like std::string_view::substr, `len` is clamped to the end of the string.
+    Buffer substr(const size_t pos, const size_t len = std::string_view::npos) const;
 };
 
 //! \brief A reference-counted discontiguous string that can discard bytes from the front
@@ -113,6 +127,16 @@ class BufferViewList {
 
     //! \brief Construct from a std::string_view
     BufferViewList(std::string_view str) { _views.push_back({const_cast<char *>(str.data()), str.size()}); }
+
+    //! \brief Construct from an array of std::string_views (e.g. from ByteStream::peek_spans), skipping empty ones
+    template <size_t N>
+    BufferViewList(const std::array<std::string_view, N> &views) {
+        for (const auto &view : views) {
+            if (not view.empty()) {
+                _views.push_back(view);
+            }
+        }
+    }
     //!@}
 
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
@@ -0,0 +1,194 @@
+#include "occupancy_bitmap.hh"
+
+#include <algorithm>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+constexpr uint64_t ALL_ONES = ~uint64_t{0};
+
+//! The low `len` bits set (`len` <= 64)
+uint64_t low_mask(const size_t len) { return len >= 64 ? ALL_ONES : (uint64_t{1} << len) - 1; }
+
+//! Bit `i` is set if `a[i] == b[i]`, for `i` < `len` (`len` <= 64)
+uint64_t equal_mask_scalar(const char *a, const char *b, const size_t len) {
+    uint64_t mask = 0;
+    for (size_t i = 0; i < len; ++i) {
+        mask |= uint64_t{a[i] == b[i]} << i;
+    }
+    return mask;
+}
+
+//! Number of leading all-ones words among `words[0, count)`
+size_t full_words_scalar(const uint64_t *words, const size_t count) {
+    size_t i = 0;
+    while (i < count and words[i] == ALL_ONES) {
+        ++i;
+    }
+    return i;
+}
+
+#if defined(__x86_64__)
+
+bool cpu_has_avx2() {
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+}
+
+__attribute__((target("avx2"))) uint64_t equal_mask_64_avx2(const char *a, const char *b) {
+    uint64_t mask = 0;
+    for (size_t i = 0; i < 64; i += 32) {
+        const auto va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        const auto vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        mask |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)))} << i;
+    }
+    return mask;
+}
+
+uint64_t equal_mask_64_sse2(const char *a, const char *b) {
+    uint64_t mask = 0;
+    for (size_t i = 0; i < 64; i += 16) {
+        const auto va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        const auto vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        mask |= uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)))} << i;
+    }
+    return mask;
+}
+
+__attribute__((target("avx2"))) size_t full_words_avx2(const uint64_t *words, const size_t count) {
+    const auto ones = _mm256_set1_epi64x(-1);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        if (not _mm256_testc_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(words + i)), ones)) {
+            break;
+        }
+    }
+    return i + full_words_scalar(words + i, count - i);
+}
+
+size_t full_words_sse2(const uint64_t *words, const size_t count) {
+    const auto ones = _mm_set1_epi64x(-1);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(words + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, ones)) != 0xFFFF) {
+            break;
+        }
+    }
+    return i + full_words_scalar(words + i, count - i);
+}
+
+#endif
+
+uint64_t equal_mask(const char *a, const char *b, const size_t len) {
+#if defined(__x86_64__)
+    if (len == 64) {
+        return cpu_has_avx2() ? equal_mask_64_avx2(a, b) : equal_mask_64_sse2(a, b);
+    }
+#endif
+    return equal_mask_scalar(a, b, len);
+}
+
+size_t full_words(const uint64_t *words, const size_t count) {
+#if defined(__x86_64__)
+    return cpu_has_avx2() ? full_words_avx2(words, count) : full_words_sse2(words, count);
+#else
+    return full_words_scalar(words, count);
+#endif
+}
+
+}  // namespace
+
+OccupancyBitmap::OccupancyBitmap(const size_t size) : _words((size + 63) / 64), _size(size) {}
+
+uint64_t OccupancyBitmap::bits(const size_t pos, const size_t len) const {
+    const auto word = pos / 64, offset = pos % 64;
+    auto value = _words[word] >> offset;
+    if (offset > 0 and offset + len > 64) {
+        value |= _words[word + 1] << (64 - offset);
+    }
+    return value & low_mask(len);
+}
+
+void OccupancyBitmap::_assign(const size_t pos, const size_t len, const bool value) {
+    size_t i = pos;
+    const size_t end = pos + len;
+    while (i < end) {
+        const auto offset = i % 64;
+        const auto n = min(64 - offset, end - i);
+        const auto mask = low_mask(n) << offset;
+        auto &word = _words[i / 64];
+        word = value ? (word | mask) : (word & ~mask);
+        i += n;
+    }
+}
+
+size_t OccupancyBitmap::count(const size_t pos, const size_t len) const {
+    size_t total = 0;
+    for (size_t i = 0; i < len; i += 64) {
+        total += __builtin_popcountll(bits(pos + i, min<size_t>(64, len - i)));
+    }
+    return total;
+}
+
+//! \details Partial words at either end are handled one word at a time; the aligned
+//! words in between are checked for being all-ones several words per instruction.
+size_t OccupancyBitmap::run_length(const size_t pos, const size_t limit) const {
+    size_t n = 0;
+    while (n < limit) {
+        const auto i = pos + n;
+        if (i % 64 == 0 and limit - n >= 64) {
+            const auto count = (limit - n) / 64;
+            const auto full = full_words(_words.data() + i / 64, count);
+            n += full * 64;
+            if (full < count) {
+                return n + __builtin_ctzll(~_words[i / 64 + full]);
+            }
+            continue;
+        }
+
+        const auto chunk = min(64 - i % 64, limit - n);
+        const auto value = bits(i, chunk);
+        if (value != low_mask(chunk)) {
+            return n + __builtin_ctzll(~value);
+        }
+        n += chunk;
+    }
+    return limit;
+}
+
+size_t OccupancyBitmap::gap_length(const size_t pos, const size_t limit) const {
+    size_t n = 0;
+    while (n < limit) {
+        const auto chunk = min(64 - (pos + n) % 64, limit - n);
+        const auto value = bits(pos + n, chunk);
+        if (value != 0) {
+            return n + __builtin_ctzll(value);
+        }
+        n += chunk;
+    }
+    return limit;
+}
+
+size_t OccupancyBitmap::first_conflict(const size_t pos,
+                                       const char *stored,
+                                       const char *incoming,
+                                       const size_t len) const {
+    for (size_t i = 0; i < len; i += 64) {
+        const auto n = min<size_t>(64, len - i);
+        const auto used = bits(pos + i, n);
+        if (used == 0) {
+            continue;
+        }
+        const auto conflicts = used & ~equal_mask(stored + i, incoming + i, n);
+        if (conflicts) {
+            return i + __builtin_ctzll(conflicts);
+        }
+    }
+    return len;
+}
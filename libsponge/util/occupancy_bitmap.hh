@@ -0,0 +1,57 @@
+#ifndef SPONGE_LIBSPONGE_OCCUPANCY_BITMAP_HH
+#define SPONGE_LIBSPONGE_OCCUPANCY_BITMAP_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//! \brief A packed bitmap (one bit per byte slot) recording which slots of a flat byte array are in use
+//!
+//! Ranges never wrap: callers that index a ring split their ranges at the end of the array.
+//! Scans use AVX2 when the CPU supports it, SSE2 otherwise, and plain 64-bit words on
+//! other architectures.
+class OccupancyBitmap {
+  private:
+    std::vector<uint64_t> _words;  //!< Bit `i % 64` of word `i / 64` is slot `i`
+    size_t _size;                  //!< Number of slots
+
+    //! Set or clear the slots [pos, pos + len)
+    void _assign(const size_t pos, const size_t len, const bool value);
+
+  public:
+    //! Construct a bitmap of `size` slots, all clear
+    explicit OccupancyBitmap(const size_t size);
+
+    //! Number of slots
+    size_t size() const { return _size; }
+
+    //! Is slot `pos` in use?
+    bool test(const size_t pos) const { return (_words[pos / 64] >> (pos % 64)) & 1; }
+
+    //! Up to 64 slots starting at `pos`, as the low `len` bits of the result
+    uint64_t bits(const size_t pos, const size_t len) const;
+
+    //! Mark the slots [pos, pos + len) as in use
+    void set(const size_t pos, const size_t len) { _assign(pos, len, true); }
+
+    //! Mark the slots [pos, pos + len) as free
+    void clear(const size_t pos, const size_t len) { _assign(pos, len, false); }
+
+    //! Number of slots in use among [pos, pos + len)
+    size_t count(const size_t pos, const size_t len) const;
+
+    //! \brief Length of the run of used slots starting at `pos`
+    //! \returns at most `limit`
+    size_t run_length(const size_t pos, const size_t limit) const;
+
+    //! \brief Length of the run of free slots starting at `pos`
+    //! \returns at most `limit`
+    size_t gap_length(const size_t pos, const size_t limit) const;
+
+    //! \brief Compare incoming bytes against the bytes already stored in used slots
+    //! \param pos is the slot of `stored[0]` and `incoming[0]`
+    //! \returns the offset of the first used slot whose stored byte differs, or `len` if none does
+    size_t first_conflict(const size_t pos, const char *stored, const char *incoming, const size_t len) const;
+};
+
+#endif  // SPONGE_LIBSPONGE_OCCUPANCY_BITMAP_HH
@@ -0,0 +1,62 @@
+#include "ring_storage.hh"
+
+#include "file_descriptor.hh"
+#include "util.hh"
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+
+using namespace std;
+
+//! \param[in] capacity is the size of the ring, in bytes
+//! \param[in] double_mapped requests the magic-ring mapping (only honored if `capacity` is page-aligned)
+RingStorage::RingStorage(const size_t capacity, const bool double_mapped) : _capacity(capacity) {
+    const auto page_size = static_cast<size_t>(SystemCall("sysconf", ::sysconf(_SC_PAGESIZE)));
+    if (not double_mapped or capacity == 0 or capacity % page_size != 0) {
+        _vector.resize(capacity);
+        return;
+    }
+
+    // the FileDescriptor closes the memfd on return; the mappings keep the pages alive
+    FileDescriptor memfd{SystemCall("memfd_create", ::memfd_create("sponge-ring", MFD_CLOEXEC))};
+    SystemCall("ftruncate", ::ftruncate(memfd.fd_num(), static_cast<off_t>(capacity)));
+
+    // reserve 2 * capacity bytes of address space, then map the same pages over each half
+    void *reservation = ::mmap(nullptr, 2 * capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reservation == MAP_FAILED) {
+        throw unix_error("mmap");
+    }
+    _mapping = static_cast<char *>(reservation);
+
+    for (size_t half = 0; half < 2; ++half) {
+        void *addr = _mapping + half * capacity;
+        if (::mmap(addr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, memfd.fd_num(), 0) == MAP_FAILED) {
+            const int error = errno;
+            _unmap();
+            throw unix_error("mmap", error);
+        }
+    }
+}
+
+void RingStorage::_unmap() {
+    if (_mapping) {
+        ::munmap(_mapping, 2 * _capacity);
+        _mapping = nullptr;
+    }
+}
+
+RingStorage::~RingStorage() { _unmap(); }
+
+RingStorage::RingStorage(RingStorage &&other) noexcept
+    : _vector(move(other._vector)), _mapping(exchange(other._mapping, nullptr)), _capacity(other._capacity) {}
+
+RingStorage &RingStorage::operator=(RingStorage &&other) noexcept {
+    if (this != &other) {
+        _unmap();
+        _vector = move(other._vector);
+        _mapping = exchange(other._mapping, nullptr);
+        _capacity = other._capacity;
+    }
+    return *this;
+}
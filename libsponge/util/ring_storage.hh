@@ -0,0 +1,53 @@
+#ifndef SPONGE_LIBSPONGE_RING_STORAGE_HH
+#define SPONGE_LIBSPONGE_RING_STORAGE_HH
+
+#include <cstddef>
+#include <vector>
+
+//! \brief Fixed-size backing storage for a circular buffer of bytes
+//!
+//! By default the bytes live in a std::vector. When a "double-mapped" (magic ring)
+//! storage is requested and `capacity` is a multiple of the page size, the same
+//! [memfd_create(2)](\ref man2::memfd_create) pages are instead mapped twice, back to back.
+//! Byte `i + capacity()` then aliases byte `i`, so any window of up to `capacity()`
+//! bytes starting anywhere in the first mapping is contiguous in virtual memory.
+class RingStorage {
+  private:
+    std::vector<char> _vector{};  //!< Backing storage when not double-mapped
+    char *_mapping = nullptr;     //!< Start of the double mapping (2 * _capacity bytes), if any
+    size_t _capacity;             //!< Size of the ring, in bytes
+
+    //! Release the double mapping, if any
+    void _unmap();
+
+  public:
+    //! \brief Allocate `capacity` bytes, double-mapped if requested and possible
+    //! \note Falls back to the vector storage when `capacity` is not page-aligned
+    explicit RingStorage(const size_t capacity, const bool double_mapped = false);
+
+    //! Unmaps the double mapping, if any
+    ~RingStorage();
+
+    //! \name
+    //! RingStorage can be moved but not copied
+
+    //!@{
+    RingStorage(RingStorage &&other) noexcept;
+    RingStorage &operator=(RingStorage &&other) noexcept;
+    RingStorage(const RingStorage &other) = delete;
+    RingStorage &operator=(const RingStorage &other) = delete;
+    //!@}
+
+    //! \brief Pointer to the first byte of the ring
+    //! \note If double_mapped(), the `2 * capacity()` bytes from here are addressable
+    char *data() { return _mapping ? _mapping : _vector.data(); }
+    const char *data() const { return _mapping ? _mapping : _vector.data(); }
+
+    //! Size of the ring, in bytes
+    size_t capacity() const { return _capacity; }
+
+    //! \returns `true` if every window of up to capacity() bytes is contiguous
+    bool double_mapped() const { return _mapping != nullptr; }
+};
+
+#endif  // SPONGE_LIBSPONGE_RING_STORAGE_HH
@@ -3,6 +3,7 @@
 #include "util.hh"
 
 #include <cstddef>
+#include <netinet/in.h>
 #include <stdexcept>
 #include <unistd.h>
 
@@ -166,3 +167,11 @@ void Socket::setsockopt(const int level, const int option, const option_type &op
 // allow local address to be reused sooner, at the cost of some robustness
 //! \note Using `SO_REUSEADDR` may reduce the robustness of your application
 void Socket::set_reuseaddr() { setsockopt(SOL_SOCKET, SO_REUSEADDR, int(true)); }
+
+//! \note The socket must be connected: the MTU is that of the route to its peer
+size_t Socket::path_mtu() const {
+    int mtu = 0;
+    socklen_t len = sizeof(mtu);
+    SystemCall("getsockopt", ::getsockopt(fd_num(), IPPROTO_IP, IP_MTU, &mtu, &len));
+    return static_cast<size_t>(mtu);
+}
@@ -45,6 +45,9 @@ class Socket : public FileDescriptor {
 
     //! Allow local address to be reused sooner via [SO_REUSEADDR](\ref man7::socket)
     void set_reuseaddr();
+
+    //! Path MTU to the connected peer, as the kernel knows it, via [IP_MTU](\ref man7::ip)
+    size_t path_mtu() const;
 };
 
 //! A wrapper around [UDP sockets](\ref man7::udp)
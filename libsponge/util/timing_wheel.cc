@@ -0,0 +1,127 @@
+#include "timing_wheel.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+//! Milliseconds spanned by a slot of level `level`
+static constexpr uint64_t slot_span(const unsigned level) { return uint64_t{1} << (TimingWheel::SLOT_BITS * level); }
+
+TimingWheel::TimingWheel() { _slots.fill(NIL); }
+
+void TimingWheel::_file(const uint32_t index) {
+    auto &entry = _entries[index];
+    const auto delay = entry.expiry_ms - _now_ms;
+    unsigned level = 0;
+    while (level + 1 < LEVELS && delay >= slot_span(level + 1)) {
+        ++level;
+    }
+    // a timer beyond the top level's reach is filed as far out as it goes, and refiled when it gets there
+    const auto when = min(entry.expiry_ms, _now_ms + slot_span(LEVELS) - 1);
+    const auto slot = (when >> (SLOT_BITS * level)) & (SLOTS - 1);
+
+    auto &head = _slots[level * SLOTS + slot];
+    entry.slot = static_cast<uint16_t>(level * SLOTS + slot);
+    entry.prev = NIL;
+    entry.next = head;
+    if (head != NIL) {
+        _entries[head].prev = index;
+    }
+    head = index;
+    _occupied[level] |= uint64_t{1} << slot;
+}
+
+void TimingWheel::_unlink(const uint32_t index) {
+    auto &entry = _entries[index];
+    auto &head = _slots[entry.slot];
+    if (entry.prev != NIL) {
+        _entries[entry.prev].next = entry.next;
+    } else {
+        head = entry.next;
+    }
+    if (entry.next != NIL) {
+        _entries[entry.next].prev = entry.prev;
+    }
+    if (head == NIL) {
+        _occupied[entry.slot / SLOTS] &= ~(uint64_t{1} << (entry.slot % SLOTS));
+    }
+}
+
+void TimingWheel::_release(const uint32_t index) {
+    auto &entry = _entries[index];
+    entry.armed = false;
+    ++entry.generation;
+    entry.next = _free;
+    _free = index;
+    --_size;
+}
+
+void TimingWheel::_cascade(const unsigned level, const size_t slot) {
+    auto index = _slots[level * SLOTS + slot];
+    _slots[level * SLOTS + slot] = NIL;
+    _occupied[level] &= ~(uint64_t{1} << slot);
+    while (index != NIL) {
+        const auto next = _entries[index].next;
+        _file(index);
+        index = next;
+    }
+}
+
+bool TimingWheel::_step(const uint64_t target_ms) {
+    while (_now_ms < target_ms) {
+        // the next non-empty slot of the lowest level in this rotation, else the start of the next rotation
+        const auto slot = _now_ms & (SLOTS - 1);
+        const auto later = slot + 1 < SLOTS ? _occupied[0] & (~uint64_t{0} << (slot + 1)) : 0;
+        const auto next_ms = _now_ms - slot + (later != 0 ? __builtin_ctzll(later) : SLOTS);
+        if (next_ms > target_ms) {
+            _now_ms = target_ms;
+            return false;
+        }
+        _now_ms = next_ms;
+
+        if ((_now_ms & (SLOTS - 1)) == 0) {
+            // each level whose rotation below has just completed brings its next slot down, the highest first
+            unsigned top = 1;
+            while (top + 1 < LEVELS && _now_ms % slot_span(top + 1) == 0) {
+                ++top;
+            }
+            for (auto level = top; level >= 1; --level) {
+                _cascade(level, (_now_ms >> (SLOT_BITS * level)) & (SLOTS - 1));
+            }
+        }
+        if (_slots[_now_ms & (SLOTS - 1)] != NIL) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TimingWheel::TimerId TimingWheel::arm(const uint64_t delay_ms, const uint64_t key) {
+    uint32_t index = _free;
+    if (index != NIL) {
+        _free = _entries[index].next;
+    } else {
+        if (_entries.size() >= NIL) {
+            throw runtime_error("TimingWheel::arm: too many timers");
+        }
+        index = static_cast<uint32_t>(_entries.size());
+        _entries.emplace_back();
+    }
+    auto &entry = _entries[index];
+    entry.expiry_ms = _now_ms + max<uint64_t>(delay_ms, 1);
+    entry.key = key;
+    entry.armed = true;
+    ++_size;
+    _file(index);
+    return {index, entry.generation};
+}
+
+bool TimingWheel::cancel(const TimerId id) {
+    if (!armed(id)) {
+        return false;
+    }
+    _unlink(id.index);
+    _release(id.index);
+    return true;
+}
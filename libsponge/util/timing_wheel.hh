@@ -0,0 +1,122 @@
+#ifndef SPONGE_LIBSPONGE_TIMING_WHEEL_HH
+#define SPONGE_LIBSPONGE_TIMING_WHEEL_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//! \brief A hierarchical timing wheel (Varghese and Lauck): many timers at millisecond resolution,
+//! with O(1) arm and cancel, and expiry in time proportional to the timers that expire
+//!
+//! Each of the LEVELS wheels has SLOTS slots; a slot of level `l` spans SLOTS^l milliseconds. A timer
+//! is filed in the lowest level whose span covers its delay, and moves down a level each time the
+//! wheel below it completes a rotation. Empty slots are skipped with a bitmap per level, so a long
+//! advance() costs one step per rotation of the lowest level, not one per millisecond.
+//!
+//! Timers carry a caller-chosen key rather than a callback: advance() hands the keys of expired
+//! timers to a visitor, so the objects they stand for may move (a TCPConnection, say) as long as
+//! the caller can find them by key.
+class TimingWheel {
+  public:
+    static constexpr unsigned SLOT_BITS = 6;
+    static constexpr size_t SLOTS = size_t{1} << SLOT_BITS;  //!< Slots per level
+    static constexpr unsigned LEVELS = 4;                    //!< Timers up to 2^24 ms (4.6 hours) away are filed
+                                                             //!< directly; later ones wait in the top level
+
+    //! \brief Identifies an armed timer; stale once it expires or is cancelled
+    struct TimerId {
+        uint32_t index = NIL;
+        uint32_t generation = 0;
+    };
+
+  private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    //! A timer, in a slab; armed ones are linked into the list of their slot
+    struct Entry {
+        uint64_t expiry_ms = 0;
+        uint64_t key = 0;
+        uint32_t prev = NIL;
+        uint32_t next = NIL;
+        uint32_t generation = 0;  //!< Bumped when the entry is freed, which invalidates its TimerIds
+        uint16_t slot = 0;        //!< Index into _slots of the list the entry is on
+        bool armed = false;
+    };
+
+    std::vector<Entry> _entries{};
+    uint32_t _free = NIL;                             //!< Head of the free list (linked by `next`)
+    std::array<uint32_t, LEVELS * SLOTS> _slots{};    //!< Head of each slot's list
+    std::array<uint64_t, LEVELS> _occupied{};         //!< Bit `s` of word `l`: slot `s` of level `l` is non-empty
+    uint64_t _now_ms = 0;
+    size_t _size = 0;
+
+    //! File an armed entry into the slot its expiry falls in
+    void _file(const uint32_t index);
+
+    //! Take an entry off its slot's list
+    void _unlink(const uint32_t index);
+
+    //! Return an entry to the free list
+    void _release(const uint32_t index);
+
+    //! Refile the timers of slot `slot` of level `level` now that the wheel below has come round to it
+    void _cascade(const unsigned level, const size_t slot);
+
+    //! \brief Step the clock to the next time a timer expires, cascading timers down at each rotation of
+    //! the lowest level on the way, but no further than `target_ms`
+    //! \returns false if nothing expires by `target_ms`, and the clock stopped there
+    bool _step(const uint64_t target_ms);
+
+  public:
+    TimingWheel();
+
+    //! \brief Arm a timer to expire `delay_ms` from now (at least 1 ms: on the next advance)
+    //! \param key is handed to advance()'s visitor when the timer expires
+    TimerId arm(const uint64_t delay_ms, const uint64_t key);
+
+    //! \brief Cancel a timer
+    //! \returns whether it was armed (false if it had expired or been cancelled already)
+    bool cancel(const TimerId id);
+
+    //! Cancel `id` (if still armed), and arm a timer in its place
+    TimerId rearm(const TimerId id, const uint64_t delay_ms, const uint64_t key) {
+        cancel(id);
+        return arm(delay_ms, key);
+    }
+
+    //! Whether `id` is armed
+    bool armed(const TimerId id) const {
+        return id.index < _entries.size() && _entries[id.index].generation == id.generation &&
+               _entries[id.index].armed;
+    }
+
+    //! Milliseconds until armed timer `id` expires (0 if it is not armed)
+    uint64_t ms_until(const TimerId id) const { return armed(id) ? _entries[id.index].expiry_ms - _now_ms : 0; }
+
+    //! \brief Move the clock forward, expiring the timers that come due, earliest first
+    //! \param visit is called with the key of each expired timer; it may arm and cancel timers
+    template <typename Visit>
+    void advance(const uint64_t ms, Visit &&visit) {
+        const auto target_ms = _now_ms + ms;
+        while (_step(target_ms)) {
+            // one at a time, so the visitor may cancel any of the others
+            const auto &due = _slots[_now_ms & (SLOTS - 1)];
+            while (due != NIL) {
+                const auto index = due;
+                const auto key = _entries[index].key;
+                _unlink(index);
+                _release(index);
+                visit(key);
+            }
+        }
+    }
+
+    //! Total milliseconds advanced
+    uint64_t now_ms() const { return _now_ms; }
+
+    //! Number of armed timers
+    size_t size() const { return _size; }
+};
+
+#endif  // SPONGE_LIBSPONGE_TIMING_WHEEL_HH
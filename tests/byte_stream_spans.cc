@@ -0,0 +1,133 @@
+#include "buffer.hh"
+#include "byte_stream.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            // a write that wraps around the end of the buffer is exposed as two spans
+            ByteStream bs{8};
+            test_err_if(bs.write(string_view{"abcdef"}) != 6, "write should accept all bytes");
+            bs.pop_output(5);
+            test_err_if(bs.write(string_view{"ghijkl"}) != 6, "write should accept bytes across the wrap point");
+
+            const auto spans = bs.peek_spans(7);
+            test_err_if(spans[0] != "fgh", "first span should end at the wrap point");
+            test_err_if(spans[1] != "ijkl", "second span should start at the front of the buffer");
+            test_err_if(bs.peek_spans(2)[0] != "fg" or not bs.peek_spans(2)[1].empty(),
+                        "a short peek should not wrap");
+            test_err_if(bs.peek_output(100) != "fghijkl", "peek_output should concatenate both spans");
+
+            char out[16]{};
+            test_err_if(bs.read_into(static_cast<char *>(out), 5) != 5, "read_into should copy 5 bytes");
+            test_err_if(string_view(static_cast<char *>(out), 5) != "fghij", "read_into copied wrong bytes");
+            test_err_if(bs.bytes_read() != 10 or bs.buffer_size() != 2, "read_into should pop what it copied");
+            test_err_if(bs.read_into(static_cast<char *>(out), 16) != 2, "read_into should stop at buffer end");
+            test_err_if(bs.read_into(static_cast<char *>(out), 16) != 0, "read_into on empty stream");
+        }
+
+        {
+            // a double-mapped stream never splits a peek, even across the wrap point
+            ByteStream bs{4096, true};
+            const string data(3000, 'x');
+            for (size_t i = 0; i < 10; ++i) {
+                test_err_if(bs.write(data) != data.size(), "write should accept all bytes");
+                const auto spans = bs.peek_spans(data.size());
+                test_err_if(spans[0] != data or not spans[1].empty(), "double-mapped peek should be one span");
+                bs.pop_output(data.size());
+            }
+        }
+
+        {
+            // Buffers written to the stream are kept as slices of the same storage
+            Buffer buffer{string{"0123456789"}};
+            const auto *storage = buffer.str().data();
+            test_err_if(buffer.substr(2, 3).str() != "234" or buffer.substr(8).str() != "89",
+                        "Buffer::substr mismatch");
+            test_err_if(buffer.substr(4, 2).str().data() != storage + 4, "Buffer::substr should not copy");
+
+            ByteStream bs{16};
+            test_err_if(bs.write(string_view{"ab"}) != 2, "write should accept all bytes");
+            test_err_if(bs.write(buffer) != 10, "write(Buffer) should accept all bytes");
+            test_err_if(bs.write(string_view{"cdef"}) != 4, "write should accept all bytes");
+            test_err_if(bs.write(Buffer{string{"ghij"}}) != 0, "write(Buffer) should respect capacity");
+            test_err_if(bs.peek_output(16) != "ab0123456789cdef", "peek_output should cross chunks");
+
+            const auto spans = bs.peek_spans(16);
+            test_err_if(spans[0] != "ab" or spans[1] != "0123456789", "peek_spans should stop after two chunks");
+            test_err_if(spans[1].data() != storage, "peek_spans should expose the Buffer itself");
+
+            bs.pop_output(1);
+            const auto buffers = bs.read_buffers(5);
+            test_err_if(buffers.buffers().size() != 2 or buffers.concatenate() != "b0123", "read_buffers mismatch");
+            test_err_if(buffers.buffers()[1].str().data() != storage, "read_buffers should slice the Buffer");
+
+            char out[16]{};
+            test_err_if(bs.read_into(static_cast<char *>(out), 16) != 10, "read_into should cross chunks");
+            test_err_if(string_view(static_cast<char *>(out), 10) != "456789cdef", "read_into copied wrong bytes");
+            test_err_if(not bs.buffer_empty(), "stream should be empty");
+        }
+
+        {
+            // a slice much smaller than its storage is copied, so the stream never pins far more than it holds
+            const Buffer big{string(1000, 'x')};
+            ByteStream bs{1000};
+            test_err_if(bs.write(big.substr(0, 100)) != 100, "write(Buffer) should accept all bytes");
+            test_err_if(bs.peek_spans(100)[0].data() == big.str().data(), "a small slice should be copied");
+            test_err_if(bs.read_buffers(100).buffers()[0].storage_size() != 100, "and read back on its own");
+
+            test_err_if(bs.write(big.substr(0, 900)) != 900, "write(Buffer) should accept all bytes");
+            test_err_if(bs.peek_spans(900)[0].data() != big.str().data(), "a large slice should be kept");
+            test_err_if(bs.write(big) != 100, "write(Buffer) should respect capacity");
+            test_err_if(bs.peek_spans(1000)[1].data() == big.str().data(), "its truncated prefix is copied");
+        }
+
+        for (const bool double_mapped : {false, true}) {
+            // random writes, peeks and reads agree with a simple string model
+            auto rd = get_random_generator();
+            const size_t capacity = double_mapped ? 8192 : 1 + rd() % 4096;
+            ByteStream bs{capacity, double_mapped};
+            string model;
+
+            for (size_t i = 0; i < 10000; ++i) {
+                string data(rd() % (capacity + 16), 0);
+                generate(data.begin(), data.end(), [&] { return rd(); });
+                const auto accepted = rd() % 4 ? bs.write(string_view{data}) : bs.write(Buffer{string{data}});
+                test_err_if(accepted != min(data.size(), capacity - model.size()), "write accepted wrong amount");
+                model.append(data, 0, accepted);
+
+                const auto len = rd() % (capacity + 16);
+                const auto spans = bs.peek_spans(len);
+                const auto joined = string(spans[0]) + string(spans[1]);
+                test_err_if(joined.empty() != (len == 0 or model.empty()), "peek_spans should make progress");
+                test_err_if(joined != model.substr(0, joined.size()) or joined.size() > len, "peek_spans mismatch");
+                test_err_if(bs.peek_output(len) != model.substr(0, len), "peek_output mismatch");
+
+                string out(rd() % (capacity + 16), 0);
+                if (rd() % 4) {
+                    const auto n = bs.read_into(out.data(), out.size());
+                    test_err_if(string_view(out.data(), n) != string_view(model).substr(0, n), "read_into mismatch");
+                    model.erase(0, n);
+                } else {
+                    const auto read = bs.read_buffers(out.size()).concatenate();
+                    test_err_if(read != model.substr(0, out.size()), "read_buffers mismatch");
+                    model.erase(0, read.size());
+                }
+                test_err_if(bs.buffer_size() != model.size(), "buffer_size mismatch");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -24,6 +24,7 @@ int main() {
     try {
         TCPConfig cfg{};
         cfg.recv_capacity = 65000;
+        cfg.congestion_control = CongestionController::Algorithm::None;  // the whole window goes out before any ACK
         auto rd = get_random_generator();
 
         // loop segments back in a different order
@@ -0,0 +1,130 @@
+#include "occupancy_bitmap.hh"
+#include "stream_reassembler.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            // runs and counts across word boundaries and the vectorized middle
+            OccupancyBitmap bitmap{1000};
+            bitmap.set(3, 900);
+            test_err_if(bitmap.run_length(3, 997) != 900, "run should stop at the first free slot");
+            test_err_if(bitmap.run_length(3, 500) != 500, "run should stop at the limit");
+            test_err_if(bitmap.run_length(2, 998) != 0, "run from a free slot should be empty");
+            test_err_if(bitmap.count(0, 1000) != 900, "count mismatch");
+            bitmap.clear(700, 1);
+            test_err_if(bitmap.run_length(64, 936) != 636, "run should stop at the cleared slot");
+            test_err_if(bitmap.count(600, 200) != 199, "count mismatch after clear");
+            test_err_if(not bitmap.test(699) or bitmap.test(700) or not bitmap.test(701), "test mismatch");
+
+            // only used slots take part in the comparison
+            const string stored(300, 'a');
+            string incoming(300, 'b');
+            test_err_if(bitmap.first_conflict(0, stored.data(), incoming.data(), 3) != 3, "free slots never conflict");
+            test_err_if(bitmap.first_conflict(0, stored.data(), incoming.data(), 300) != 3,
+                        "first used slot conflicts");
+            fill(incoming.begin(), incoming.end(), 'a');
+            incoming[250] = 'c';
+            test_err_if(bitmap.first_conflict(0, stored.data(), incoming.data(), 300) != 250, "conflict offset");
+        }
+
+        {
+            // the bitmap engine keeps an inconsistent segment only up to the first disagreement
+            StreamReassembler buf{64, false, StreamReassembler::Engine::Bitmap};
+            buf.push_substring("cdef", 2, false);
+            buf.push_substring("bcXefg", 1, false);
+            test_err_if(buf.unassembled_bytes() != 5, "bytes after the disagreement should be discarded");
+            buf.push_substring("a", 0, false);
+            test_err_if(buf.stream_out().read(64) != "abcdef", "bytes before the disagreement should be kept");
+        }
+
+        {
+            // a Buffer's bytes reach the output stream without a copy, whether in order or not
+            StreamReassembler buf{64};
+            const Buffer first{string{"abcd"}}, second{string{"efgh"}};
+            buf.push_substring(second, 4, true);
+            buf.push_substring(first, 0, false);
+            const auto out = buf.stream_out().read_buffers(64);
+            test_err_if(out.concatenate() != "abcdefgh" or not buf.stream_out().eof(), "Buffer reassembly mismatch");
+            test_err_if(out.buffers().size() != 2 or out.buffers()[0].str().data() != first.str().data() or
+                            out.buffers()[1].str().data() != second.str().data(),
+                        "Buffer bytes should not be copied");
+        }
+
+        {
+            // small out-of-order slices of a large buffer are copied rather than pinning it
+            StreamReassembler buf{1000};
+            const Buffer big{string(64 * 1024, 'x')};
+            for (size_t i = 1; i < 1000; i += 2) {
+                buf.push_substring(big.substr(i, 1), i, false);
+            }
+            test_err_if(buf.unassembled_bytes() != 500, "every other byte should be pending");
+            test_err_if(buf.pending_storage() > ByteStream::MAX_PIN_RATIO * buf.unassembled_bytes(),
+                        "pending slices should pin storage bounded by their size");
+
+            // a slice that is a large part of its buffer is still kept without a copy
+            StreamReassembler kept{1000};
+            const Buffer small{string(1000, 'y')};
+            kept.push_substring(small.substr(10, 300), 10, false);
+            test_err_if(kept.pending_storage() != small.storage_size(), "a large slice should share its buffer");
+            kept.push_substring(small.substr(0, 10), 0, false);
+            test_err_if(kept.stream_out().buffer_size() != 310 or kept.pending_storage() != 0,
+                        "the slices should reach the output stream");
+        }
+
+        // both engines assemble the same random, overlapping, wrapping segments identically
+        auto rd = get_random_generator();
+        for (unsigned rep_no = 0; rep_no < 64; ++rep_no) {
+            const size_t capacity = 1 + rd() % 5000;
+            const size_t total = capacity * (1 + rd() % 8);
+            string d(total, 0);
+            generate(d.begin(), d.end(), [&] { return rd(); });
+
+            StreamReassembler interval{capacity, false, StreamReassembler::Engine::Interval};
+            StreamReassembler bitmap{capacity, false, StreamReassembler::Engine::Bitmap};
+            string out_interval, out_bitmap;
+
+            while (out_interval.size() < total) {
+                const size_t first = interval.stream_out().bytes_written();
+                const size_t off = first - min<size_t>(first, rd() % 64) + rd() % (capacity + 64);
+                if (off >= total) {
+                    continue;
+                }
+                const size_t len = min<size_t>(total - off, rd() % (capacity / 2 + 2));
+                const bool eof = off + len == total;
+                if (rd() % 2) {
+                    interval.push_substring(d.substr(off, len), off, eof);
+                } else {
+                    interval.push_substring(Buffer{d.substr(off, len)}, off, eof);
+                }
+                bitmap.push_substring(d.substr(off, len), off, eof);
+
+                test_err_if(interval.unassembled_bytes() != bitmap.unassembled_bytes(), "unassembled bytes differ");
+                test_err_if(interval.stream_out().bytes_written() != bitmap.stream_out().bytes_written(),
+                            "assembled bytes differ");
+                if (rd() % 2) {
+                    out_interval += interval.stream_out().read(capacity);
+                    out_bitmap += bitmap.stream_out().read(capacity);
+                }
+            }
+
+            test_err_if(out_interval != d or out_bitmap != d, "engines should reassemble the original stream");
+            test_err_if(not interval.stream_out().eof() or not bitmap.stream_out().eof(), "both streams should end");
+            test_err_if(not interval.empty() or not bitmap.empty(), "nothing should be left unassembled");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -29,6 +29,7 @@ int main() {
         auto rd = get_random_generator();
         TCPConfig cfg{};
         cfg.send_capacity = MAX_SWIN * MAX_SWIN_MUL;
+        cfg.congestion_control = CongestionController::Algorithm::None;  // only the receiver's window limits sending
 
         // test 1: listen -> established -> check advertised winsize -> check sent bytes before ACK
         for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
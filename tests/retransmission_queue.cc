@@ -0,0 +1,77 @@
+#include "retransmission_queue.hh"
+#include "test_err_if.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//! Append a segment of `length` payload bytes at `abs_seqno`
+static void push(RetransmissionQueue &queue, const uint64_t abs_seqno, const size_t length) {
+    auto &out = queue.push_back();
+    test_err_if(out.abs_seqno != 0 or out.sacked or out.segment.length_in_sequence_space() != 0,
+                "push_back should hand out a cleared slot");
+    out.abs_seqno = abs_seqno;
+    out.segment.payload() = string(length, 'x');
+}
+
+int main() {
+    try {
+        {
+            RetransmissionQueue queue{3};
+            test_err_if(queue.capacity() != 4 or not queue.empty(), "the capacity rounds up to a power of two");
+
+            // wrap around the ring a few times
+            uint64_t seqno = 0;
+            for (int round = 0; round < 5; ++round) {
+                push(queue, seqno, 10);
+                push(queue, seqno + 10, 10);
+                push(queue, seqno + 20, 10);
+                test_err_if(queue.front().abs_seqno != seqno or queue[2].end() != seqno + 30, "oldest first");
+                queue[1].sacked = true;
+                queue.pop_front(3);
+                seqno += 30;
+            }
+            test_err_if(not queue.empty() or queue.capacity() != 4, "the ring should not grow while it has room");
+
+            // grow while wrapped: the order survives
+            push(queue, 0, 10);
+            queue.pop_front();
+            for (uint64_t i = 0; i < 6; ++i) {
+                push(queue, 10 + 10 * i, 10);
+            }
+            test_err_if(queue.capacity() != 8 or queue.size() != 6, "the ring should double when full");
+            for (size_t i = 0; i < queue.size(); ++i) {
+                test_err_if(queue[i].abs_seqno != 10 + 10 * i, "growing should keep the order");
+            }
+        }
+
+        {
+            // segments [1, 11) [11, 21) [21, 26) [26, 27), as after a SYN
+            RetransmissionQueue queue;
+            push(queue, 0, 1);
+            queue.pop_front();
+            push(queue, 1, 10);
+            push(queue, 11, 10);
+            push(queue, 21, 5);
+            push(queue, 26, 1);
+
+            test_err_if(queue.count_ending_by(1) != 0, "nothing is acknowledged yet");
+            test_err_if(queue.count_ending_by(15) != 1, "a partial ACK covers the first segment");
+            test_err_if(queue.count_ending_by(21) != 2, "an ACK at a boundary covers the segments before it");
+            test_err_if(queue.count_ending_by(27) != 4, "everything is acknowledged");
+
+            test_err_if(queue.find_starting_from(11) != 1, "a segment starting exactly there");
+            test_err_if(queue.find_starting_from(12) != 2, "the next segment start");
+            test_err_if(queue.find_starting_from(0) != 0, "the oldest segment");
+            test_err_if(queue.find_starting_from(27) != 4, "past the newest segment");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
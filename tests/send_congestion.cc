@@ -0,0 +1,196 @@
+#include "bbr_controller.hh"
+#include "congestion_controller.hh"
+#include "cubic_controller.hh"
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+#include "wrapping_integers.hh"
+
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        {
+            // slow start, then one MSS per window in congestion avoidance
+            NewRenoController reno{MSS};
+            test_err_if(reno.cwnd() != NewRenoController::INITIAL_WINDOW * MSS, "initial window");
+            reno.on_ack({4 * MSS, 6 * MSS, 0});
+            test_err_if(reno.cwnd() != 14 * MSS, "slow start should grow by the bytes acked");
+
+            reno.on_loss(14 * MSS, 0);
+            test_err_if(reno.cwnd() != 7 * MSS or reno.ssthresh() != 7 * MSS, "loss should halve the window");
+            for (size_t i = 0; i < 6; ++i) {
+                reno.on_ack({MSS, 6 * MSS, 0});
+            }
+            test_err_if(reno.cwnd() != 7 * MSS, "avoidance should wait for a full window of ACKs");
+            reno.on_ack({MSS, 6 * MSS, 0});
+            test_err_if(reno.cwnd() != 8 * MSS, "avoidance should grow by one MSS per window");
+
+            reno.on_rto(8 * MSS, 0);
+            test_err_if(reno.cwnd() != MSS or reno.ssthresh() != 4 * MSS, "RTO should restart from one segment");
+            reno.on_ack({5 * MSS, 0, 0});
+            test_err_if(reno.cwnd() != 4 * MSS, "slow start should stop at ssthresh");
+        }
+
+        {
+            // CUBIC: back to W_max after K seconds, then convex growth beyond it
+            CubicController cubic{MSS};
+            test_err_if(cubic.ssthresh() != numeric_limits<size_t>::max(), "no ssthresh before the first loss");
+            cubic.on_ack({90 * MSS, 0, 0});
+            test_err_if(cubic.cwnd() != 100 * MSS, "slow start should grow by the bytes acked");
+            cubic.on_loss(100 * MSS, 0);
+            test_err_if(cubic.cwnd() != 70 * MSS or cubic.w_max() != 100 * MSS, "loss should scale the window by BETA");
+
+            // one ACK per segment, 100 ms round trips
+            uint64_t now = 0;
+            const auto run_until = [&](const uint64_t end_ms) {
+                for (; now < end_ms; now += 100) {
+                    for (size_t i = cubic.cwnd() / MSS; i > 0; --i) {
+                        cubic.on_ack({MSS, 0, now});
+                    }
+                }
+            };
+            const auto k_ms = static_cast<uint64_t>(1000 * cbrt(30 / CubicController::C));
+            run_until(k_ms / 2);
+            test_err_if(cubic.cwnd() <= 85 * MSS or cubic.cwnd() >= 100 * MSS, "should grow quickly at first");
+            run_until(k_ms);
+            test_err_if(cubic.cwnd() < 98 * MSS or cubic.cwnd() > 102 * MSS, "should reach W_max after K seconds");
+            run_until(2 * k_ms);
+            test_err_if(cubic.cwnd() < 120 * MSS, "should probe beyond W_max");
+
+            // fast convergence: a loss below the previous W_max lowers W_max further
+            cubic.on_loss(cubic.cwnd(), now);
+            cubic.on_loss(cubic.cwnd(), now);
+            test_err_if(cubic.w_max() >= cubic.cwnd() * 100 / 70, "fast convergence should lower W_max");
+        }
+
+        {
+            // BBR: STARTUP until the bandwidth stops growing, DRAIN, then PROBE_BW; PROBE_RTT when min_rtt expires
+            BBRController bbr{MSS};
+            uint64_t now = 0, delivered = 0;
+            const auto round_trip = [&](const uint64_t rate, const uint64_t rtt, const size_t in_flight) {
+                AckSample sample;
+                sample.acked_bytes = 10 * MSS;
+                sample.prior_delivered = delivered;  // every ACK ends a round
+                delivered += sample.acked_bytes;
+                sample.delivered = delivered;
+                sample.bytes_in_flight = in_flight;
+                sample.now_ms = now;
+                sample.delivery_rate = rate;
+                sample.rtt_ms = rtt;
+                bbr.on_ack(sample);
+                now += rtt;
+            };
+
+            for (const uint64_t rate : {100'000, 200'000, 400'000, 800'000}) {
+                round_trip(rate, 50, 20 * MSS);
+            }
+            test_err_if(bbr.state() != BBRController::State::Startup, "should stay in STARTUP while bw grows");
+            test_err_if(bbr.pacing_rate() <= 2 * 800'000, "STARTUP should pace at a high gain");
+            for (unsigned i = 0; i < 3; ++i) {
+                round_trip(700'000, 50, 100 * MSS);
+            }
+            test_err_if(bbr.state() != BBRController::State::Drain, "flat bw for three rounds should end STARTUP");
+            test_err_if(bbr.btl_bw() != 800'000 or bbr.min_rtt_ms() != 50u, "model estimates");
+            test_err_if(bbr.bdp() != 40'000, "BDP should be btl_bw * min_rtt");
+
+            round_trip(800'000, 50, 30 * MSS);
+            test_err_if(bbr.state() != BBRController::State::ProbeBW, "DRAIN should end once in-flight <= BDP");
+            test_err_if(bbr.cwnd() > 2 * 40'000 + 3 * MSS, "PROBE_BW should keep about two BDPs in flight");
+
+            while (now < 10'500) {
+                round_trip(800'000, 60, 40 * MSS);
+            }
+            test_err_if(bbr.state() != BBRController::State::ProbeRTT, "an expired min_rtt should start PROBE_RTT");
+            test_err_if(bbr.cwnd() != BBRController::MIN_CWND_SEGMENTS * MSS,
+                        "PROBE_RTT should use the minimum window");
+            const auto probe_rtt_start = now;
+            while (bbr.state() == BBRController::State::ProbeRTT and now < probe_rtt_start + 1000) {
+                round_trip(800'000, 60, 4 * MSS);
+            }
+            test_err_if(now < probe_rtt_start + BBRController::PROBE_RTT_MS, "PROBE_RTT ended too early");
+            test_err_if(bbr.state() != BBRController::State::ProbeBW, "PROBE_RTT should end after 200 ms and a round");
+            test_err_if(bbr.min_rtt_ms() != 60u, "the expired min_rtt should be replaced");
+        }
+
+        {
+            // a sender built from a TCPConfig keeps at most min(cwnd, rwnd) in flight
+            TCPConfig cfg;
+            const WrappingInt32 isn{0};
+            cfg.fixed_isn = isn;
+            TCPSender sender{cfg};
+            const auto &cc = sender.congestion_controller();
+
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.ack_received(isn + 1, 60000);
+            sender.stream_in().write(string(60000, 'x'));
+            sender.fill_window();
+            test_err_if(sender.bytes_in_flight() != cc.cwnd(), "the congestion window should limit sending");
+            test_err_if(cc.cwnd() >= 60000, "the congestion window should start below the receiver window");
+
+            const auto before = cc.cwnd();
+            sender.ack_received(isn + 1 + sender.bytes_in_flight(), 60000);
+            test_err_if(cc.cwnd() != 2 * before, "slow start should double the window every RTT");
+            test_err_if(sender.bytes_in_flight() != cc.cwnd(), "the sender should fill the grown window");
+
+            while (sender.bytes_in_flight() > 0) {
+                sender.ack_received(sender.next_seqno(), 1000);
+            }
+            test_err_if(sender.next_seqno_absolute() != 60001, "everything should be sent and acknowledged");
+            sender.stream_in().write(string(5000, 'x'));
+            sender.fill_window();
+            test_err_if(sender.bytes_in_flight() != 1000, "the receiver window should limit sending");
+
+            sender.tick(cfg.rt_timeout);
+            test_err_if(cc.cwnd() != MSS, "a timeout should shrink the window to one segment");
+        }
+
+        {
+            // the sender samples RTT and delivery rate for the controller
+            TCPConfig cfg;
+            const WrappingInt32 isn{0};
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionController::Algorithm::BBR;
+            TCPSender sender{cfg};
+            const auto &bbr = dynamic_cast<const BBRController &>(sender.congestion_controller());
+
+            sender.fill_window();
+            sender.tick(10);
+            sender.ack_received(isn + 1, 60000);
+            test_err_if(bbr.min_rtt_ms() != 10u, "the SYN's ACK should give an RTT sample");
+
+            sender.stream_in().write(string(10 * MSS, 'x'));
+            sender.fill_window();
+            test_err_if(sender.bytes_in_flight() != 10 * MSS, "the initial window should be sent");
+            sender.tick(20);
+            sender.ack_received(isn + 1 + 10 * MSS, 60000);
+            test_err_if(bbr.btl_bw() != 10 * MSS * 1000 / 20, "10 segments delivered in 20 ms");
+            test_err_if(bbr.min_rtt_ms() != 10u, "a longer RTT should not replace min_rtt");
+        }
+
+        {
+            // the legacy constructor keeps flow control only
+            TCPSender sender{TCPConfig::DEFAULT_CAPACITY, TCPConfig::TIMEOUT_DFLT, WrappingInt32{0}};
+            sender.fill_window();
+            sender.ack_received(WrappingInt32{1}, 60000);
+            sender.stream_in().write(string(60000, 'x'));
+            sender.fill_window();
+            test_err_if(sender.bytes_in_flight() != 60000, "only the receiver window should limit sending");
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
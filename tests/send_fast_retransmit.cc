@@ -0,0 +1,131 @@
+#include "congestion_controller.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_pair_helpers.hh"
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+//! Drop everything the sender has queued, returning how many segments there were
+static size_t drain(TCPSender &sender) {
+    const auto n = sender.segments_out().size();
+    while (not sender.segments_out().empty()) {
+        sender.segments_out().pop();
+    }
+    return n;
+}
+
+int main() {
+    try {
+        const WrappingInt32 isn{0};
+        TCPConfig cfg;
+        cfg.fixed_isn = isn;
+
+        {
+            // fast retransmit on the third duplicate, then NewReno fast recovery with a partial ACK
+            TCPSender sender{cfg};
+            const auto &reno = dynamic_cast<const NewRenoController &>(sender.congestion_controller());
+            sender.fill_window();
+            sender.ack_received(isn + 1, 60000);
+            drain(sender);
+            // the SYN's ACK grew cwnd by one byte: fill it exactly, then queue more
+            sender.stream_in().write(string(10 * MSS + 1, 'x'));
+            sender.fill_window();
+            test_err_if(drain(sender) != 11 or sender.bytes_in_flight() != reno.cwnd(), "the window should be full");
+            sender.stream_in().write(string(5 * MSS, 'x'));
+
+            sender.ack_received(isn + 1, 60000);
+            sender.ack_received(isn + 1, 60000);
+            test_err_if(drain(sender) != 0 or sender.duplicate_acks() != 2, "two duplicates are not a loss");
+            sender.ack_received(isn + 1, 60000, 5);
+            sender.ack_received(isn + 1, 50000);
+            test_err_if(sender.duplicate_acks() != 2, "ACKs with data or a window update are not duplicates");
+
+            sender.ack_received(isn + 1, 50000);
+            test_err_if(sender.segments_out().size() != 1, "the third duplicate should trigger a retransmission");
+            test_err_if(sender.segments_out().front().header().seqno != isn + 1, "of the oldest segment");
+            test_err_if(not sender.in_fast_recovery() or reno.cwnd() != 5 * MSS, "and halve the window");
+            drain(sender);
+
+            // each further duplicate inflates the window by one segment: new data once it passes the flight
+            sender.ack_received(isn + 1, 50000);
+            sender.ack_received(isn + 1, 50000);
+            test_err_if(drain(sender) != 0, "cwnd + inflation is still below the flight");
+            sender.ack_received(isn + 1, 50000);
+            test_err_if(sender.segments_out().size() != 1 or
+                            sender.segments_out().front().header().seqno != isn + 2 + 10 * MSS,
+                        "inflation should let new data out");
+            drain(sender);
+
+            // a partial ACK retransmits the next hole and stays in recovery
+            sender.ack_received(isn + 1 + 3 * MSS, 50000);
+            test_err_if(sender.segments_out().empty() or
+                            sender.segments_out().front().header().seqno != isn + 1 + 3 * MSS,
+                        "a partial ACK should retransmit the first unacknowledged segment");
+            test_err_if(not sender.in_fast_recovery(), "a partial ACK should not end recovery");
+            drain(sender);
+
+            // the full ACK ends recovery at the reduced window
+            sender.ack_received(sender.next_seqno(), 50000);
+            test_err_if(sender.in_fast_recovery() or reno.cwnd() != 5 * MSS, "a full ACK should end recovery");
+            test_err_if(drain(sender) != 4, "the rest of the stream fits the reduced window");
+        }
+
+        {
+            // duplicates of a window that has already been recovered do not start another recovery
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.ack_received(isn + 1, 60000);
+            sender.stream_in().write(string(4 * MSS, 'x'));
+            sender.fill_window();
+            for (int i = 0; i < 3; ++i) {
+                sender.ack_received(isn + 1, 60000);
+            }
+            sender.ack_received(isn + 1 + 4 * MSS, 60000);
+            test_err_if(sender.in_fast_recovery(), "the full ACK should end recovery");
+            drain(sender);
+
+            sender.stream_in().write(string(4 * MSS, 'x'));
+            sender.fill_window();
+            sender.tick(TCPConfig::TIMEOUT_DFLT);
+            test_err_if(drain(sender) != 3, "two new segments fit the halved window, then a timeout retransmits");
+            for (int i = 0; i < 3; ++i) {
+                sender.ack_received(isn + 1 + 4 * MSS, 60000);
+            }
+            test_err_if(sender.in_fast_recovery() or drain(sender) != 0,
+                        "duplicates of the window sent before the timeout should be ignored");
+        }
+
+        {
+            // a receiver acknowledges every out-of-order segment, even while its owner has yet to send
+            // the ACKs already queued: those are the duplicates fast retransmit counts
+            TCPConnection x{cfg}, y{cfg};
+            handshake(x, y);
+            x.write(string(4 * MSS, 'x'));
+            const auto data = take(x);
+            test_err_if(data.size() != 4, "four segments");
+            for (size_t i = 1; i < data.size(); ++i) {
+                y.segment_received(data[i]);
+            }
+            const auto acks = take(y);
+            test_err_if(acks.size() != 3, "one ACK per out-of-order segment");
+            for (const auto &ack : acks) {
+                test_err_if(ack.header().ackno != data[0].header().seqno, "each a duplicate");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
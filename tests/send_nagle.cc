@@ -0,0 +1,100 @@
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+//! Pop the next segment, returning its payload (and checking there was one)
+static string next_payload(TCPSender &sender) {
+    test_err_if(sender.segments_out().empty(), "expected a segment");
+    const auto payload = sender.segments_out().front().payload().copy();
+    sender.segments_out().pop();
+    return payload;
+}
+
+//! A sender past its handshake
+static TCPSender connected_sender(const TCPConfig &cfg) {
+    TCPSender sender{cfg};
+    sender.fill_window();
+    sender.segments_out().pop();
+    sender.ack_received(cfg.fixed_isn.value() + 1, 60000);
+    return sender;
+}
+
+int main() {
+    try {
+        const WrappingInt32 isn{0};
+        TCPConfig cfg;
+        cfg.fixed_isn = isn;
+        test_err_if(not connected_sender(cfg).nodelay(), "small writes are sent at once by default");
+
+        {
+            // Nagle: one partial segment in flight at a time; the rest coalesce until it is acknowledged
+            cfg.nodelay = false;
+            auto sender = connected_sender(cfg);
+            sender.stream_in().write(string("a"));
+            sender.fill_window();
+            test_err_if(next_payload(sender) != "a", "nothing is in flight: send at once");
+            sender.stream_in().write(string("b"));
+            sender.fill_window();
+            sender.stream_in().write(string("cd"));
+            sender.fill_window();
+            test_err_if(not sender.segments_out().empty(), "small writes wait while data is unacknowledged");
+            sender.ack_received(isn + 2, 60000);
+            test_err_if(next_payload(sender) != "bcd", "the ACK releases them as one segment");
+
+            // a full segment is never delayed; only the partial tail waits
+            sender.stream_in().write(string(MSS + 10, 'x'));
+            sender.fill_window();
+            test_err_if(next_payload(sender).size() != MSS or not sender.segments_out().empty(),
+                        "full segments go out, the partial one waits");
+
+            // neither is the end of the stream
+            sender.stream_in().end_input();
+            sender.fill_window();
+            test_err_if(sender.segments_out().empty() or not sender.segments_out().front().header().fin,
+                        "the tail goes out with the FIN");
+            test_err_if(next_payload(sender).size() != 10, "the held bytes");
+        }
+
+        {
+            // no delay: every write is sent
+            cfg.nodelay = true;
+            auto sender = connected_sender(cfg);
+            for (const auto *chunk : {"a", "b", "c"}) {
+                sender.stream_in().write(string(chunk));
+                sender.fill_window();
+                test_err_if(next_payload(sender) != chunk, "each small write is its own segment");
+            }
+        }
+
+        {
+            // cork: partial segments wait even with nothing in flight, until uncorked
+            auto sender = connected_sender(cfg);
+            sender.set_corked(true);
+            sender.stream_in().write(string("header"));
+            sender.fill_window();
+            test_err_if(not sender.segments_out().empty(), "corked: a partial segment waits");
+            sender.stream_in().write(string(MSS, 'x'));
+            sender.fill_window();
+            test_err_if(next_payload(sender) != "header" + string(MSS - 6, 'x') or not sender.segments_out().empty(),
+                        "corked: a full segment goes out");
+            sender.set_corked(false);
+            sender.fill_window();
+            test_err_if(next_payload(sender) != string(6, 'x'), "uncorking releases the tail");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+#include "congestion_controller.hh"
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+//! Drop everything the sender has queued, returning how many segments there were
+static size_t drain(TCPSender &sender) {
+    const auto n = sender.segments_out().size();
+    while (not sender.segments_out().empty()) {
+        sender.segments_out().pop();
+    }
+    return n;
+}
+
+int main() {
+    try {
+        const WrappingInt32 isn{0};
+        TCPConfig cfg;
+        cfg.fixed_isn = isn;
+
+        {
+            // NewReno does not pace: the whole window goes out at once
+            TCPSender sender{cfg};
+            test_err_if(sender.pacing_rate() != 0, "NewReno should not ask for pacing");
+            sender.fill_window();
+            sender.ack_received(isn + 1, 60000);
+            drain(sender);
+            sender.stream_in().write(string(20 * MSS, 'x'));
+            sender.fill_window();
+            test_err_if(sender.bytes_in_flight() != sender.congestion_controller().cwnd(),
+                        "an unpaced sender should fill cwnd");
+            test_err_if(sender.ms_until_release().has_value(), "nothing is held back without pacing");
+        }
+
+        {
+            // 1 MB/s is a segment per millisecond, with a two-segment bucket (no cwnd, to isolate pacing)
+            cfg.congestion_control = CongestionController::Algorithm::None;
+            cfg.pacing_rate = 1'000'000;
+            TCPSender sender{cfg};
+            test_err_if(sender.pacing_rate() != 1'000'000, "the configured rate overrides the controller");
+            sender.fill_window();
+            sender.ack_received(isn + 1, 60000);
+            test_err_if(drain(sender) != 1, "the SYN");
+
+            sender.stream_in().write(string(20 * MSS, 'x'));
+            sender.fill_window();
+            test_err_if(drain(sender) != 10, "the initial quantum (less the SYN) should release ten segments");
+            test_err_if(sender.bytes_in_flight() != 10 * MSS, "held-back data is not in flight");
+            test_err_if(sender.ms_until_release() != 1, "the bucket owes a byte: wait a millisecond");
+
+            sender.fill_window();
+            test_err_if(drain(sender) != 0, "no tokens are earned without time passing");
+            sender.tick(1);
+            test_err_if(drain(sender) != 1, "a millisecond earns one segment");
+            sender.tick(5);
+            test_err_if(drain(sender) != 2, "an idle bucket fills only up to its burst");
+            test_err_if(sender.ms_until_release() != 1, "an empty bucket waits for the next millisecond");
+
+            // pacing only delays new data: a timeout still retransmits immediately
+            sender.tick(TCPConfig::TIMEOUT_DFLT - 7);
+            test_err_if(drain(sender) != 2, "the bucket is still capped at the burst");
+            sender.tick(1);
+            test_err_if(drain(sender) != 2, "the retransmission plus the millisecond's segment");
+        }
+
+        {
+            // the FIN is paced with the data it follows
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.ack_received(isn + 1, 60000);
+            drain(sender);
+            sender.stream_in().write(string(11 * MSS, 'x'));
+            sender.stream_in().end_input();
+            sender.fill_window();
+            test_err_if(drain(sender) != 10 or sender.next_seqno_absolute() != 10 * MSS + 1,
+                        "the FIN should wait for tokens");
+            test_err_if(not sender.ms_until_release().has_value(), "the last segment is held back");
+            sender.tick(1);
+            test_err_if(drain(sender) != 1 or sender.next_seqno_absolute() != 11 * MSS + 2,
+                        "the last segment and the FIN are released");
+            test_err_if(sender.ms_until_release().has_value(), "nothing is left to hold back");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,96 @@
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            // the RFC 6298 filters, with the clock granularity and the bounds
+            RTTEstimator rtt{1000, 200, 60000};
+            test_err_if(rtt.srtt_ms().has_value() or rtt.rto() != 1000, "no sample: the initial RTO");
+            rtt.add_sample(100);
+            test_err_if(rtt.srtt_ms() != 100 or rtt.rttvar_ms() != 50, "the first sample sets SRTT and RTT/2");
+            test_err_if(rtt.rto() != 300, "RTO = SRTT + 4 * RTTVAR");
+            rtt.add_sample(20);
+            test_err_if(rtt.srtt_ms() != 90 or rtt.rttvar_ms() != 57.5, "RTTVAR uses the previous SRTT");
+            test_err_if(rtt.rto() != 320, "RTO = 90 + 230");
+
+            RTTEstimator lan{1000, 1, 60000};
+            for (int i = 0; i < 100; ++i) {
+                lan.add_sample(2);
+            }
+            test_err_if(lan.rto() != 3, "with no variance the RTO is SRTT + G");
+            RTTEstimator floored{1000, 200, 60000};
+            floored.add_sample(2);
+            test_err_if(floored.rto() != 200, "the RTO should not go below the minimum");
+            test_err_if(floored.backoff(40000) != 60000 or floored.backoff(20000) != 40000, "backoff is capped");
+        }
+
+        {
+            // an adaptive sender arms its timer from the estimate, and keeps a backoff until a valid sample
+            TCPConfig cfg;
+            const WrappingInt32 isn{0};
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 10;
+            TCPSender sender{cfg};
+
+            sender.fill_window();
+            sender.segments_out().pop();
+            test_err_if(sender.rto_ms() != TCPConfig::TIMEOUT_DFLT, "the initial RTO before any sample");
+            sender.tick(4);
+            sender.ack_received(isn + 1, 10000);
+            test_err_if(sender.rtt_estimator().srtt_ms() != 4, "the SYN's ACK should be sampled");
+            test_err_if(sender.rto_ms() != 12, "4 + 4 * 2");
+
+            sender.stream_in().write(string("hello"));
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.tick(11);
+            test_err_if(not sender.segments_out().empty(), "no retransmission before the RTO");
+            sender.tick(1);
+            test_err_if(sender.segments_out().size() != 1, "retransmission after the adaptive RTO");
+            sender.segments_out().pop();
+            test_err_if(sender.rto_ms() != 24, "the RTO should back off");
+
+            // the ACK of a retransmitted segment gives no sample (Karn), so the backoff stays
+            sender.tick(20);
+            sender.ack_received(isn + 6, 10000);
+            test_err_if(sender.rtt_estimator().srtt_ms() != 4, "a retransmitted segment should not be sampled");
+            test_err_if(sender.rto_ms() != 24, "the backed-off RTO should be kept without a sample");
+
+            sender.stream_in().write(string("world"));
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.tick(4);
+            sender.ack_received(isn + 11, 10000);
+            test_err_if(sender.rto_ms() != 10, "a valid sample recomputes the RTO, within the minimum");
+        }
+
+        {
+            // without adaptive_rto, samples are still taken but the timer keeps the configured timeout
+            TCPConfig cfg;
+            const WrappingInt32 isn{0};
+            cfg.fixed_isn = isn;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.tick(4);
+            sender.ack_received(isn + 1, 10000);
+            test_err_if(sender.rtt_estimator().srtt_ms() != 4, "the estimate should be available");
+            test_err_if(sender.rto_ms() != TCPConfig::TIMEOUT_DFLT, "the RTO should stay fixed");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,54 @@
+#include "buffer.hh"
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        TCPConfig cfg;
+        const WrappingInt32 isn{1000};
+        TCPSender sender{cfg.send_capacity, cfg.rt_timeout, isn};
+
+        // SYN, then open a big window
+        sender.fill_window();
+        sender.segments_out().pop();
+        sender.ack_received(isn + 1, 10000);
+
+        // a BufferList written by the application is cut into payloads without a copy
+        const Buffer first{string(2500, 'a')}, second{string(1500, 'b')};
+        BufferList data{first};
+        data.append(second);
+        test_err_if(sender.stream_in().write(data) != 4000, "write(BufferList) should accept all bytes");
+        sender.fill_window();
+
+        auto &out = sender.segments_out();
+        test_err_if(out.size() != 4, "expected four segments");
+        test_err_if(out.front().payload().str().data() != first.str().data(), "first payload should slice the Buffer");
+        out.pop();
+        test_err_if(out.front().payload().str().data() != first.str().data() + 1000, "second payload should slice");
+        out.pop();
+        test_err_if(out.front().payload().str() != string(500, 'a') + string(500, 'b'),
+                    "a payload spanning two Buffers should hold both");
+        out.pop();
+        test_err_if(out.front().payload().str().data() != second.str().data() + 500, "last payload should slice");
+        out.pop();
+
+        // a retransmission shares the original storage too
+        sender.tick(cfg.rt_timeout);
+        test_err_if(out.size() != 1 or out.front().payload().str().data() != first.str().data(),
+                    "retransmission should reuse the Buffer");
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,94 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_pair_helpers.hh"
+#include "test_err_if.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        TCPConfig cfg;
+        cfg.delayed_ack = true;
+        TCPConnection x{cfg}, y{cfg};
+        x.connect();
+        deliver(x, y);
+        deliver(y, x);
+        test_err_if(deliver(x, y).size() != 1, "the SYN/ACK is acknowledged at once");
+        test_err_if(deliver(y, x).size() != 0, "a pure ACK is not acknowledged");
+
+        // every second full-size segment is acknowledged
+        x.write(string(MSS, 'a'));
+        deliver(x, y);
+        test_err_if(not y.segments_out().empty(), "the first segment's ACK waits");
+        x.write(string(MSS, 'b'));
+        deliver(x, y);
+        test_err_if(deliver(y, x).size() != 1, "the second segment is acknowledged");
+        test_err_if(x.bytes_in_flight() != 0, "that ACK covers both");
+        test_err_if(y.ack_counters().pure_acks_suppressed != 1, "one ACK was saved");
+
+        // a small segment waits for the timer
+        x.write(string(100, 'c'));
+        deliver(x, y);
+        y.tick(cfg.delayed_ack_timeout - 1);
+        test_err_if(not y.segments_out().empty(), "the ACK waits for the timer");
+        y.tick(1);
+        test_err_if(deliver(y, x).size() != 1 or y.ack_counters().delayed_ack_timeouts != 1, "the timer sends it");
+
+        // out-of-order data, and the segment filling the hole, are acknowledged at once
+        x.write(string(2 * MSS, 'd'));
+        auto segments = take(x);
+        test_err_if(segments.size() != 2, "two segments");
+        y.segment_received(segments[1]);
+        test_err_if(deliver(y, x).size() != 1, "out-of-order data: an immediate (duplicate) ACK");
+        y.segment_received(segments[0]);
+        test_err_if(deliver(y, x).size() != 1, "the hole is filled: an immediate ACK");
+
+        // the application reading two segments' worth opens the window: the pending ACK goes out
+        x.write(string(100, 'e'));
+        deliver(x, y);
+        test_err_if(not y.segments_out().empty(), "the ACK waits");
+        y.inbound_stream().pop_output(y.inbound_stream().buffer_size());
+        y.tick(0);
+        test_err_if(deliver(y, x).size() != 1 or y.ack_counters().delayed_ack_timeouts != 1, "a window update");
+
+        // a FIN is acknowledged at once
+        x.end_input_stream();
+        deliver(x, y);
+        test_err_if(deliver(y, x).size() != 1, "the FIN's ACK is immediate");
+        test_err_if(y.ack_counters().pure_acks_sent != 6 or y.ack_counters().pure_acks_suppressed != 1,
+                    "ACK counters");
+
+        // without delayed ACKs, every segment is acknowledged
+        TCPConnection a{TCPConfig{}}, b{TCPConfig{}};
+        handshake(a, b);
+        a.write(string(MSS, 'a'));
+        deliver(a, b);
+        test_err_if(deliver(b, a).size() != 1, "an immediate ACK");
+        test_err_if(b.ack_counters().pure_acks_suppressed != 0, "nothing suppressed");
+
+        for (auto *conn : {&x, &y, &a, &b}) {
+            conn->end_input_stream();
+        }
+        for (int i = 0; i < 4; ++i) {
+            deliver(x, y);
+            deliver(y, x);
+            deliver(a, b);
+            deliver(b, a);
+            for (auto *conn : {&x, &y, &a, &b}) {
+                conn->tick(10 * cfg.rt_timeout);
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
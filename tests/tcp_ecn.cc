@@ -0,0 +1,219 @@
+#include "arp_message.hh"
+#include "dctcp_controller.hh"
+#include "ethernet_frame.hh"
+#include "parser.hh"
+#include "router.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "tcp_pair_helpers.hh"
+#include "test_err_if.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+using ECN = IPv4Header::ECN;
+
+//! Mark an ECN-capable segment CE, as a congested router would
+static void mark_ce(TCPSegment &seg) {
+    if (seg.ecn() != ECN::NotECT) {
+        seg.set_ecn(ECN::CE);
+    }
+}
+
+//! An Ethernet frame carrying `payload` from `src` to `dst`
+static EthernetFrame frame(const EthernetAddress &src,
+                           const EthernetAddress &dst,
+                           const uint16_t type,
+                           const BufferList &payload) {
+    EthernetFrame f;
+    f.header().src = src;
+    f.header().dst = dst;
+    f.header().type = type;
+    f.payload() = payload.concatenate();
+    return f;
+}
+
+int main() {
+    try {
+        {
+            // the flags round-trip, and the codepoint leaves the rest of the TOS byte alone
+            TCPHeader header;
+            header.ece = true;
+            header.cwr = true;
+            NetParser p{header.serialize()};
+            TCPHeader parsed;
+            parsed.parse(p);
+            test_err_if(not parsed.ece or not parsed.cwr, "ECE and CWR should round-trip");
+
+            IPv4Header ip;
+            ip.tos = 0xb8;
+            ip.set_ecn(ECN::CE);
+            test_err_if(ip.tos != 0xbb or ip.ecn() != ECN::CE, "the ECN field is the low two bits");
+
+            TCPSegment seg;
+            seg.header().cwr = true;
+            seg.payload() = string(10, 'x');
+            seg.set_ecn(ECN::ECT0);
+            const auto pieces = seg.split(4);
+            test_err_if(pieces.size() != 3 or pieces[1].header().cwr or pieces[2].ecn() != ECN::ECT0,
+                        "pieces keep the codepoint, and only the first carries CWR");
+        }
+
+        TCPConfig ecn;
+        ecn.ecn = true;
+
+        {
+            // set up on the SYNs, then new data goes out ECN-capable; a connection without it is left alone
+            TCPConnection x{ecn}, y{ecn};
+            x.connect();
+            const auto syn = deliver(x, y).at(0);
+            test_err_if(not syn.header().ece or not syn.header().cwr, "the SYN asks with ECE and CWR");
+            const auto syn_ack = deliver(y, x).at(0);
+            test_err_if(not syn_ack.header().ece or syn_ack.header().cwr, "the SYN/ACK accepts with ECE");
+            test_err_if(syn.ecn() != ECN::NotECT or syn_ack.ecn() != ECN::NotECT, "SYNs are never ECN-capable");
+            deliver(x, y);
+            x.write("data");
+            test_err_if(deliver(x, y).at(0).ecn() != ECN::ECT0, "data is ECN-capable");
+            test_err_if(deliver(y, x).at(0).ecn() != ECN::NotECT, "a pure ACK is not");
+
+            TCPConnection legacy_x{ecn}, legacy_y{TCPConfig{}};
+            handshake(legacy_x, legacy_y);
+            legacy_x.write("data");
+            test_err_if(deliver(legacy_x, legacy_y).at(0).ecn() != ECN::NotECT, "without the peer's consent, not");
+        }
+
+        {
+            // a mark is echoed on every ACK until the sender's CWR, and costs one reduction per window
+            TCPConnection x{ecn}, y{ecn};
+            handshake(x, y);
+            x.write(string(5000, 'x'));
+            deliver(x, y, mark_ce);
+            const auto acks = deliver(y, x);
+            test_err_if(acks.empty() or not acks.back().header().ece, "the mark is echoed");
+            test_err_if(x.ecn_reductions() != 1, "one reduction for the window (the SYN/ACK's ECE is no echo)");
+
+            x.write(string(5000, 'x'));
+            const auto data = deliver(x, y);
+            test_err_if(data.empty() or not data.at(0).header().cwr, "the next new data carries CWR");
+            for (size_t i = 1; i < data.size(); ++i) {
+                test_err_if(data[i].header().cwr, "only the first");
+            }
+            for (const auto &ack : deliver(y, x)) {
+                test_err_if(ack.header().ece, "CWR ends the echo");
+            }
+            test_err_if(x.ecn_reductions() != 1, "no further reduction");
+        }
+
+        {
+            // the controllers: NewReno halves, DCTCP cuts by alpha / 2, and alpha follows the marks
+            NewRenoController reno{1000};
+            reno.on_ecn(20000, 0);
+            test_err_if(reno.cwnd() != 10000, "classic: as for a loss");
+
+            DCTCPController dctcp{1000};
+            uint64_t delivered = 0;
+            const auto window = [&](const bool marked) {
+                for (size_t i = 0; i < 10; ++i) {
+                    AckSample sample;
+                    sample.acked_bytes = 1000;
+                    delivered += 1000;
+                    sample.delivered = delivered;
+                    sample.bytes_in_flight = 9000;
+                    sample.ece = marked and i == 0;  // one segment in ten
+                    dctcp.on_ack(sample);
+                }
+            };
+            for (size_t i = 0; i < 100; ++i) {
+                window(true);
+            }
+            test_err_if(dctcp.alpha() < 0.09 or dctcp.alpha() > 0.11, "alpha converges on the fraction marked");
+            const auto cwnd = dctcp.cwnd();
+            dctcp.on_ecn(cwnd, 0);
+            test_err_if(dctcp.cwnd() < cwnd * 94 / 100 or dctcp.cwnd() > cwnd * 96 / 100, "a cut of alpha / 2");
+        }
+
+        {
+            // DCTCP negotiates ECN by itself, and its receiver echoes each segment's mark exactly
+            TCPConfig dctcp;
+            dctcp.congestion_control = CongestionController::Algorithm::DCTCP;
+            dctcp.delayed_ack = true;
+            TCPConnection x{dctcp}, y{dctcp};
+            handshake(x, y);
+            x.write(string(2000, 'x'));
+            auto data = take(x);
+            test_err_if(data.size() != 2 or data[0].ecn() != ECN::ECT0, "ECN is in use");
+            y.segment_received(data[0]);
+            test_err_if(not y.segments_out().empty(), "the first segment's ACK is delayed");
+            data[1].set_ecn(ECN::CE);
+            y.segment_received(data[1]);
+            const auto held = take(y);
+            test_err_if(held.size() != 1 or held[0].header().ece or held[0].header().ackno != data[1].header().seqno,
+                        "a change of mark sends the delayed ACK at once, unmarked, for the first segment");
+            y.tick(dctcp.delayed_ack_timeout);
+            const auto marked = take(y);
+            test_err_if(marked.size() != 1 or not marked[0].header().ece, "the second segment's ACK is marked");
+
+            x.write(string(1000, 'x'));
+            deliver(x, y);
+            y.tick(dctcp.delayed_ack_timeout);
+            const auto next = take(y);
+            test_err_if(next.size() != 1 or next[0].header().ece, "an unmarked segment clears the echo, no CWR needed");
+        }
+
+        {
+            // the router marks ECN-capable datagrams once the outbound queue reaches the threshold
+            const EthernetAddress in_eth{2, 0, 0, 0, 0, 1}, out_eth{2, 0, 0, 0, 0, 2};
+            const EthernetAddress src_eth{2, 0, 0, 0, 0, 3}, dst_eth{2, 0, 0, 0, 0, 4};
+            Router router;
+            router.add_interface(AsyncNetworkInterface{in_eth, Address{"10.0.0.1"}});
+            router.add_interface(AsyncNetworkInterface{out_eth, Address{"10.0.1.1"}});
+            router.add_route(Address{"10.0.1.0"}.ipv4_numeric(), 24, {}, 1);
+            router.set_ecn_marking_threshold(2);
+
+            ARPMessage reply;
+            reply.opcode = ARPMessage::OPCODE_REPLY;
+            reply.sender_ethernet_address = dst_eth;
+            reply.sender_ip_address = Address{"10.0.1.2"}.ipv4_numeric();
+            reply.target_ethernet_address = out_eth;
+            reply.target_ip_address = Address{"10.0.1.1"}.ipv4_numeric();
+            router.interface(1).recv_frame(frame(dst_eth, out_eth, EthernetHeader::TYPE_ARP, reply.serialize()));
+
+            const auto send = [&](const ECN codepoint) {
+                InternetDatagram dgram;
+                dgram.header().src = Address{"10.0.0.2"}.ipv4_numeric();
+                dgram.header().dst = Address{"10.0.1.2"}.ipv4_numeric();
+                dgram.header().set_ecn(codepoint);
+                dgram.payload() = string("hello");
+                dgram.header().len = dgram.header().hlen * 4 + dgram.payload().size();
+                router.interface(0).recv_frame(frame(src_eth, in_eth, EthernetHeader::TYPE_IPv4, dgram.serialize()));
+                router.route();
+            };
+            for (const auto codepoint : {ECN::ECT0, ECN::ECT0, ECN::ECT0, ECN::NotECT, ECN::ECT1}) {
+                send(codepoint);
+            }
+
+            vector<ECN> seen;
+            auto &frames = router.interface(1).frames_out();
+            while (not frames.empty()) {
+                InternetDatagram dgram;
+                test_err_if(dgram.parse(frames.front().payload().concatenate()) != ParseResult::NoError, "a datagram");
+                seen.push_back(dgram.header().ecn());
+                frames.pop();
+            }
+            test_err_if((seen != vector<ECN>{ECN::ECT0, ECN::ECT0, ECN::CE, ECN::NotECT, ECN::CE}),
+                        "marked from the third queued datagram, unless not ECN-capable");
+            test_err_if(router.ecn_marked() != 2, "two marks");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,96 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_pair_helpers.hh"
+#include "test_err_if.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        TCPConfig cfg;
+        cfg.delayed_ack = true;
+
+        {
+            // a bulk transfer to a receiver that has closed its side: the handshake and the FINs take the
+            // slow path, the data and its ACKs the fast one
+            TCPConnection x{cfg}, y{cfg};
+            handshake(x, y);
+            y.end_input_stream();
+            deliver(y, x);
+            deliver(x, y);
+            test_err_if(x.prediction_counters().fast_path != 0 or y.prediction_counters().fast_path != 0,
+                        "the handshake and y's FIN are not predicted");
+
+            const string data(50000, 'x');
+            size_t written = 0;
+            string received;
+            for (size_t round = 0; round < 100 and received.size() < data.size(); ++round) {
+                written += x.write(data.substr(written, 10000));
+                deliver(x, y);
+                received += y.inbound_stream().read(y.inbound_stream().buffer_size());
+                y.tick(cfg.delayed_ack_timeout);
+                deliver(y, x);
+            }
+            test_err_if(received != data, "the data arrives");
+            test_err_if(x.bytes_in_flight() != 0, "and is acknowledged");
+            test_err_if(y.prediction_counters().fast_path != 50, "every data segment is predicted");
+            test_err_if(x.prediction_counters().fast_path == 0, "so are the ACKs");
+            test_err_if(y.ack_counters().pure_acks_suppressed == 0, "ACKs are still delayed on the fast path");
+
+            x.end_input_stream();
+            const auto slow = y.prediction_counters().slow_path;
+            deliver(x, y);
+            test_err_if(y.prediction_counters().slow_path != slow + 1, "a FIN takes the slow path");
+        }
+
+        {
+            // out of order, a window update, or a duplicate ACK: the slow path
+            TCPConnection x{cfg}, y{cfg};
+            handshake(x, y);
+            x.write(string(3000, 'x'));
+            auto data = take(x);
+            test_err_if(data.size() != 3, "three segments");
+            const auto before = y.prediction_counters();
+            y.segment_received(data[1]);
+            test_err_if(y.prediction_counters().slow_path != before.slow_path + 1, "out of order: slow");
+            y.segment_received(data[0]);
+            test_err_if(y.prediction_counters().slow_path != before.slow_path + 2, "filling a hole: slow");
+            y.segment_received(data[2]);
+            test_err_if(y.prediction_counters().fast_path != before.fast_path + 1, "then in order again: fast");
+            test_err_if(y.inbound_stream().buffer_size() != 3000, "all of it delivered");
+
+            const auto acks = take(y);
+            test_err_if(acks.size() != 2, "the out-of-order segment and the filled hole are acknowledged at once");
+            const auto x_before = x.prediction_counters();
+            x.segment_received(acks[0]);
+            test_err_if(x.prediction_counters().slow_path != x_before.slow_path + 1, "an ACK with SACK blocks: slow");
+            x.segment_received(acks[1]);
+            test_err_if(x.prediction_counters().fast_path != x_before.fast_path + 1, "an ACK of new data: fast");
+            x.segment_received(acks[1]);
+            test_err_if(x.prediction_counters().slow_path != x_before.slow_path + 2, "a duplicate ACK: slow");
+            y.tick(cfg.delayed_ack_timeout);
+            deliver(y, x);
+            test_err_if(x.bytes_in_flight() != 0 or x.prediction_counters().fast_path != x_before.fast_path + 2,
+                        "the delayed ACK: fast");
+
+            // data from y whose window has changed since x last heard: slow, so that the window is taken
+            y.inbound_stream().read(3000);
+            y.write("reply");
+            const auto reply = take(y);
+            test_err_if(reply.size() != 1, "one segment");
+            x.segment_received(reply[0]);
+            test_err_if(x.prediction_counters().slow_path != x_before.slow_path + 3, "a window update: slow");
+            test_err_if(x.inbound_stream().buffer_size() != 5, "the reply arrives");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
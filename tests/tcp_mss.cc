@@ -0,0 +1,91 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_pair_helpers.hh"
+#include "test_err_if.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! The payload sizes of `segments`
+static vector<size_t> sizes(const vector<TCPSegment> &segments) {
+    vector<size_t> ret;
+    for (const auto &seg : segments) {
+        ret.push_back(seg.payload().size());
+    }
+    return ret;
+}
+
+int main() {
+    try {
+        {
+            TCPHeader header;
+            header.syn = true;
+            header.mss = 1460;
+            header.sack_permitted = true;
+            test_err_if(header.options_length() != 8, "MSS and SACK-permitted");
+            header.doff = (TCPHeader::LENGTH + header.options_length()) / 4;
+            test_err_if(not(reparse(header) == header), "the options should round-trip");
+            test_err_if(TCPOverIPv4Adapter::mss_for_mtu(1500) != 1420, "room for IPv4 and the largest TCP header");
+        }
+
+        TCPConfig big, small;
+        big.mss = 8000;
+        small.mss = 4000;
+
+        {
+            // each side offers its own MSS; both send the smaller
+            TCPConnection x{big}, y{small};
+            x.connect();
+            const auto syn = deliver(x, y);
+            test_err_if(syn.size() != 1 or syn[0].header().mss != 8000, "the SYN offers x's MSS");
+            const auto syn_ack = deliver(y, x);
+            test_err_if(syn_ack.size() != 1 or syn_ack[0].header().mss != 4000, "the SYN/ACK offers y's");
+            deliver(x, y);
+
+            x.write(string(10000, 'x'));
+            test_err_if((sizes(deliver(x, y)) != vector<size_t>{4000, 4000, 2000}), "x sends y's MSS");
+            deliver(y, x);
+            y.write(string(10000, 'y'));
+            test_err_if((sizes(deliver(y, x)) != vector<size_t>{4000, 4000, 2000}), "y sends its own");
+        }
+
+        {
+            // without the peer's option, a connection keeps to its own
+            TCPConnection x{big}, y{small};
+            x.connect();
+            deliver(x, y);
+            auto syn_ack = take(y);
+            syn_ack.at(0).header().mss.reset();
+            x.segment_received(syn_ack.at(0));
+            deliver(x, y);
+            x.write(string(10000, 'x'));
+            test_err_if((sizes(deliver(x, y)) != vector<size_t>{8000, 2000}), "x keeps its own MSS");
+        }
+
+        {
+            // super-segments are tagged with the MSS for the adapter to cut them to
+            TCPConfig tso = big;
+            tso.tso_size = 32000;
+            TCPConnection x{tso}, y{small};
+            handshake(x, y);
+            x.write(string(20000, 'x'));
+            const auto segments = take(x);
+            test_err_if(segments.size() != 1 or segments[0].payload().size() != 20000, "one super-segment");
+            test_err_if(segments[0].wire_mss() != 4000 or not segments[0].needs_split(), "tagged with the MSS");
+            test_err_if(sizes(segments[0].split(segments[0].wire_mss())) != vector<size_t>(5, 4000),
+                        "cut into MSS-sized wire segments");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
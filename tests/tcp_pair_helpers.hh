@@ -0,0 +1,71 @@
+#ifndef SPONGE_TESTS_TCP_PAIR_HELPERS_HH
+#define SPONGE_TESTS_TCP_PAIR_HELPERS_HH
+
+#include "parser.hh"
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+//! \file
+//! Helpers for tests that wire two TCPConnections back to back, with no network between them,
+//! and for tests of the header options
+
+//! A header after a round trip through serialize() and parse()
+inline TCPHeader reparse(const TCPHeader &header) {
+    NetParser p{header.serialize()};
+    TCPHeader parsed;
+    if (parsed.parse(p) != ParseResult::NoError) {
+        throw std::runtime_error("the serialized header should parse");
+    }
+    return parsed;
+}
+
+//! Take the segments `from` has queued
+inline std::vector<TCPSegment> take(TCPConnection &from) {
+    std::vector<TCPSegment> segments;
+    while (not from.segments_out().empty()) {
+        segments.push_back(std::move(from.segments_out().front()));
+        from.segments_out().pop();
+    }
+    return segments;
+}
+
+//! Move the queued segments from one connection to the other, first passing each to `edit` (as a
+//! router rewriting them would), and return them
+template <typename Edit>
+std::vector<TCPSegment> deliver(TCPConnection &from, TCPConnection &to, Edit &&edit) {
+    auto segments = take(from);
+    for (auto &seg : segments) {
+        edit(seg);
+        to.segment_received(seg);
+    }
+    return segments;
+}
+
+//! Move the queued segments from one connection to the other, and return them
+inline std::vector<TCPSegment> deliver(TCPConnection &from, TCPConnection &to) {
+    return deliver(from, to, [](TCPSegment &) {});
+}
+
+//! Move the queued segments from one connection to the other, and return the last, which there must be
+inline TCPSegment deliver_last(TCPConnection &from, TCPConnection &to) {
+    auto segments = deliver(from, to);
+    if (segments.empty()) {
+        throw std::runtime_error("expected a segment");
+    }
+    return std::move(segments.back());
+}
+
+//! Connect `x` to `y`: the SYN, the SYN/ACK and the ACK
+inline void handshake(TCPConnection &x, TCPConnection &y) {
+    x.connect();
+    deliver(x, y);
+    deliver(y, x);
+    deliver(x, y);
+}
+
+#endif  // SPONGE_TESTS_TCP_PAIR_HELPERS_HH
@@ -0,0 +1,145 @@
+#include "retransmission_queue.hh"
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+static const WrappingInt32 ISN{0};
+
+//! Seqno of the `i`th data segment
+static WrappingInt32 seqno(const size_t i) { return ISN + 1 + static_cast<uint32_t>(i * MSS); }
+
+//! Drop what the sender has queued, returning the seqnos
+static vector<WrappingInt32> take(TCPSender &sender) {
+    vector<WrappingInt32> seqnos;
+    while (not sender.segments_out().empty()) {
+        seqnos.push_back(sender.segments_out().front().header().seqno);
+        sender.segments_out().pop();
+    }
+    return seqnos;
+}
+
+//! A sender that has had its SYN acknowledged after `rtt_ms`, and sent `segments` full segments
+static TCPSender sender_with_data(const bool sack_permitted, const size_t segments, const uint64_t rtt_ms = 10) {
+    TCPConfig cfg;
+    cfg.fixed_isn = ISN;
+    cfg.adaptive_rto = true;
+    TCPSender sender{cfg};
+    sender.set_sack_permitted(sack_permitted);
+    sender.fill_window();
+    sender.tick(rtt_ms);
+    sender.ack_received(ISN + 1, 60000);
+    sender.stream_in().write(string(segments * MSS, 'x'));
+    sender.fill_window();
+    take(sender);
+    return sender;
+}
+
+int main() {
+    try {
+        {
+            // the transmissions are walked oldest first, which a retransmission reorders
+            RetransmissionQueue queue;
+            for (uint64_t i = 0; i < 3; ++i) {
+                auto &out = queue.push_back();
+                out.abs_seqno = 1 + i * MSS;
+                out.segment.payload() = string(MSS, 'x');
+                queue.transmitted(out, 0);
+            }
+            queue.transmitted(queue.front(), 5);
+            const auto order = [&] {
+                vector<uint64_t> seqnos;
+                queue.for_each_by_transmission([&](const OutstandingSegment &out) {
+                    seqnos.push_back(out.abs_seqno);
+                    return true;
+                });
+                return seqnos;
+            };
+            test_err_if((order() != vector<uint64_t>{1 + MSS, 1 + 2 * MSS, 1}), "the retransmission comes last");
+            queue[1].sacked = true;
+            test_err_if((order() != vector<uint64_t>{1 + 2 * MSS, 1}), "SACKed segments are skipped");
+            queue.pop_front();
+            test_err_if((order() != vector<uint64_t>{1 + 2 * MSS}), "acknowledged ones are gone");
+        }
+
+        {
+            // a lone segment at the tail is lost: a probe goes out well before the RTO
+            auto sender = sender_with_data(true, 3);
+            sender.tick(5);
+            sender.ack_received(seqno(2), 60000);
+            const auto rto = sender.rto_ms();
+            uint64_t waited = 0;
+            while (sender.segments_out().empty() and waited < rto) {
+                sender.tick(1);
+                ++waited;
+            }
+            test_err_if(waited >= rto, "the probe comes before the RTO");
+            test_err_if(waited < 2 * 10, "but no sooner than two round trips");
+            test_err_if((take(sender) != vector<WrappingInt32>{seqno(2)}), "the probe resends the last segment");
+            test_err_if(not sender.tlp_in_flight(), "a probe is in flight");
+
+            sender.tick(2 * 10 + TCPSender::TLP_MAX_ACK_DELAY);
+            test_err_if(not take(sender).empty(), "one probe per tail");
+
+            // with no DSACK to tell otherwise, the probe is taken to have repaired a loss
+            const auto cwnd = sender.congestion_controller().cwnd();
+            sender.ack_received(seqno(3), 60000);
+            test_err_if(sender.tlp_in_flight() or sender.bytes_in_flight() != 0, "the probe is answered");
+            test_err_if(sender.congestion_controller().cwnd() >= cwnd, "and cwnd is reduced");
+        }
+
+        {
+            // without SACK there is no probe: the tail waits for the RTO
+            auto sender = sender_with_data(false, 3);
+            sender.tick(5);
+            sender.ack_received(seqno(2), 60000);
+            sender.tick(sender.rto_ms() - 1);
+            test_err_if(not sender.segments_out().empty(), "nothing before the RTO");
+            sender.tick(1);
+            test_err_if((take(sender) != vector<WrappingInt32>{seqno(2)}), "the RTO retransmits it");
+        }
+
+        {
+            // one SACK is no loss by the duplicate-ACK count, but in time it is one by RACK's
+            auto sender = sender_with_data(true, 4);
+            sender.tick(10);
+            sender.ack_received(seqno(0), 60000, 0, {{seqno(1), seqno(2)}});
+            test_err_if(not take(sender).empty() or sender.in_fast_recovery(), "reordering is allowed for");
+            sender.tick(10 / 4 - 1);
+            test_err_if(not take(sender).empty(), "for a quarter of the minimum RTT");
+            sender.tick(1);
+            test_err_if((take(sender) != vector<WrappingInt32>{seqno(0)}), "then the segment is lost");
+            test_err_if(not sender.in_fast_recovery(), "and recovery begins");
+
+            // segments 2 and 3, sent after segment 1 and SACKed, say nothing about its retransmission
+            sender.tick(10);
+            sender.ack_received(seqno(0), 60000, 0, {{seqno(1), seqno(4)}});
+            test_err_if(not take(sender).empty(), "the retransmission was sent after them");
+            sender.ack_received(seqno(4), 60000);
+            test_err_if(sender.in_fast_recovery() or sender.bytes_in_flight() != 0, "the full ACK ends recovery");
+        }
+
+        {
+            // after the same SACK, without SACK having been permitted, nothing happens until three duplicates
+            auto sender = sender_with_data(false, 4);
+            sender.tick(10);
+            sender.ack_received(seqno(0), 60000, 0, {{seqno(1), seqno(2)}});
+            sender.tick(10);
+            test_err_if(not take(sender).empty() or sender.in_fast_recovery(), "no time-based detection");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+#include "parser.hh"
+#include "stream_reassembler.hh"
+#include "tcp_config.hh"
+#include "tcp_header.hh"
+#include "tcp_pair_helpers.hh"
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+static TCPSegment data_segment(const WrappingInt32 seqno, const size_t len) {
+    TCPSegment seg;
+    seg.header().seqno = seqno;
+    seg.payload() = string(len, 'x');
+    return seg;
+}
+
+int main() {
+    try {
+        {
+            // the options round-trip, and doff decides how many of them are written
+            TCPHeader header;
+            header.syn = true;
+            header.sack_permitted = true;
+            header.sack_blocks = {{WrappingInt32{100}, WrappingInt32{200}}, {WrappingInt32{300}, WrappingInt32{400}}};
+            test_err_if(header.options_length() != 4 + 4 + 16, "SACK-permitted, then two blocks, NOP-aligned");
+            header.doff = (TCPHeader::LENGTH + header.options_length()) / 4;
+            test_err_if(not(reparse(header) == header), "the options should round-trip");
+
+            header.doff = 5;
+            const auto bare = reparse(header);
+            test_err_if(bare.sack_permitted or not bare.sack_blocks.empty(), "no room, no options");
+            header.doff = 8;
+            test_err_if(reparse(header).sack_blocks.size() != 0, "a SACK option needs room for a whole block");
+
+            header.sack_blocks.resize(6, {WrappingInt32{1}, WrappingInt32{2}});
+            test_err_if(header.options_length() != 4 + 4 + 4 * 8, "at most four blocks fit");
+
+            // options we do not understand are skipped; a malformed one ends option processing
+            string raw = TCPHeader{}.serialize();
+            raw[12] = static_cast<char>(10 << 4);
+            raw += string{"\x02\x04\x05\xb4"                  // MSS
+                          "\x01\x01\x04\x02"                  // NOP, NOP, SACK-permitted
+                          "\x08\x0a\x00\x00\x00\x01\x00\x00"  // timestamps
+                          "\x00\x02\x05\x20",                 // rest of timestamps; SACK longer than the header
+                          20};
+            NetParser p{move(raw)};
+            TCPHeader parsed;
+            test_err_if(parsed.parse(p) != ParseResult::NoError, "unknown options should not fail the parse");
+            test_err_if(not parsed.sack_permitted or not parsed.sack_blocks.empty(), "only SACK-permitted is valid");
+        }
+
+        for (const auto engine : {StreamReassembler::Engine::Interval, StreamReassembler::Engine::Bitmap}) {
+            // the receiver reports its holes, most recent block first
+            const WrappingInt32 isn{1000};
+            TCPReceiver receiver{4000, false, engine};
+            TCPSegment syn;
+            syn.header().syn = true;
+            syn.header().seqno = isn;
+            syn.header().sack_permitted = true;
+            receiver.segment_received(syn);
+            test_err_if(not receiver.sack_permitted() or not receiver.sack_blocks().empty(), "nothing to SACK yet");
+
+            receiver.segment_received(data_segment(isn + 1 + 100, 100));
+            receiver.segment_received(data_segment(isn + 1 + 300, 100));
+            receiver.segment_received(data_segment(isn + 1 + 200, 50));
+            const vector<TCPSackBlock> expected{{isn + 101, isn + 251}, {isn + 301, isn + 401}};
+            test_err_if(receiver.sack_blocks() != expected, "the block with the latest segment comes first");
+
+            receiver.segment_received(data_segment(isn + 1 + 3900, 100));  // wraps around the bitmap's ring
+            test_err_if(receiver.sack_blocks().size() != 3 or
+                            not(receiver.sack_blocks().front() == TCPSackBlock{isn + 3901, isn + 4001}),
+                        "a block at the end of the window");
+
+            receiver.segment_received(data_segment(isn + 1, 400));
+            test_err_if(receiver.sack_blocks().size() != 1, "filling the holes leaves one block");
+        }
+
+        {
+            // the sender retransmits only the segments the scoreboard deems lost
+            const WrappingInt32 isn{0};
+            TCPConfig cfg;
+            cfg.fixed_isn = isn;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            test_err_if(not sender.segments_out().front().header().sack_permitted, "the SYN should offer SACK");
+            sender.segments_out().pop();
+            sender.ack_received(isn + 1, 60000);
+            sender.stream_in().write(string(10 * MSS + 1, 'x'));
+            sender.fill_window();
+            while (not sender.segments_out().empty()) {
+                sender.segments_out().pop();
+            }
+
+            // segments 1 and 3 are lost; the others arrive
+            const auto seqno = [&](const size_t i) { return isn + 1 + i * MSS; };
+            sender.ack_received(seqno(1), 60000);
+            sender.ack_received(seqno(1), 60000, 0, {{seqno(2), seqno(3)}});
+            sender.ack_received(seqno(1), 60000, 0, {{seqno(4), seqno(5)}, {seqno(2), seqno(3)}});
+            test_err_if(not sender.segments_out().empty(), "two duplicates are not a loss");
+            sender.ack_received(seqno(1), 60000, 0, {{seqno(4), seqno(6)}, {seqno(2), seqno(3)}});
+            test_err_if(sender.segments_out().size() != 1 or sender.segments_out().front().header().seqno != seqno(1),
+                        "the third duplicate retransmits the first hole");
+            sender.segments_out().pop();
+
+            sender.ack_received(seqno(1), 60000, 0, {{seqno(4), seqno(7)}, {seqno(2), seqno(3)}});
+            test_err_if(sender.segments_out().size() != 1 or sender.segments_out().front().header().seqno != seqno(3),
+                        "three segments SACKed after the second hole mark it lost too");
+            sender.segments_out().pop();
+
+            sender.ack_received(seqno(1), 60000, 0, {{seqno(4), seqno(8)}, {seqno(2), seqno(3)}});
+            test_err_if(not sender.segments_out().empty(), "SACKed segments are never retransmitted");
+
+            sender.ack_received(seqno(3), 60000, 0, {{seqno(4), seqno(8)}});
+            test_err_if(not sender.in_fast_recovery() or not sender.segments_out().empty(),
+                        "a partial ACK whose next hole was already retransmitted sends nothing");
+            sender.ack_received(sender.next_seqno(), 60000);
+            test_err_if(sender.in_fast_recovery() or sender.bytes_in_flight() != 0, "the full ACK ends recovery");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "tcp_pair_helpers.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            // the option round-trips, and leaves room for three SACK blocks
+            TCPHeader header;
+            header.ack = true;
+            header.timestamps = TCPTimestamps{0x01020304, 0xfffffffe};
+            header.sack_blocks.resize(4, {WrappingInt32{1}, WrappingInt32{2}});
+            test_err_if(header.options_length() != 12 + 4 + 3 * 8, "timestamps, then three blocks");
+            header.doff = (TCPHeader::LENGTH + header.options_length()) / 4;
+            const auto parsed = reparse(header);
+            test_err_if(not(parsed.timestamps == header.timestamps), "the timestamps should round-trip");
+            test_err_if(parsed.sack_blocks.size() != 3, "only three blocks fit");
+        }
+
+        {
+            // an ACK of a retransmission still gives an RTT sample: the echo says which copy it answers
+            TCPConfig cfg;
+            cfg.adaptive_rto = true;
+            cfg.fixed_isn = WrappingInt32{0};
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.tick(cfg.rt_timeout);
+            test_err_if(sender.segments_out().size() != 2, "the SYN is retransmitted");
+            sender.tick(30);
+            sender.ack_received(WrappingInt32{1}, 1000, 0, {}, cfg.rt_timeout);
+            test_err_if(sender.rtt_estimator().srtt_ms() != 30.0, "the echo times the retransmission");
+
+            TCPSender karn{cfg};
+            karn.fill_window();
+            karn.tick(cfg.rt_timeout);
+            karn.tick(30);
+            karn.ack_received(WrappingInt32{1}, 1000);
+            test_err_if(karn.rtt_estimator().srtt_ms().has_value(), "without timestamps, Karn discards the sample");
+        }
+
+        TCPConfig cfg;
+        {
+            TCPConnection x{cfg}, y{cfg};
+            x.connect();
+            y.tick(7);
+            const auto syn = deliver_last(x, y);
+            test_err_if(not(syn.header().timestamps == TCPTimestamps{0, 0}), "the SYN offers timestamps");
+            const auto syn_ack = deliver_last(y, x);
+            test_err_if(not(syn_ack.header().timestamps == TCPTimestamps{7, 0}), "the SYN/ACK accepts, echoing");
+            deliver_last(x, y);
+
+            // every segment carries the sender's clock and echoes the peer's latest
+            x.tick(10);
+            x.write(string(100, 'a'));
+            const auto data = deliver_last(x, y);
+            test_err_if(not(data.header().timestamps == TCPTimestamps{10, 7}), "data is stamped with x's clock");
+            const auto ack = deliver_last(y, x);
+            test_err_if(not ack.header().timestamps.has_value() or ack.header().timestamps->echo != 10,
+                        "the ACK echoes it");
+
+            // PAWS: a segment stamped before the latest one is an old duplicate, even though its seqno is fine
+            x.tick(10);
+            x.write(string(100, 'b'));
+            auto stale = take(x).back();
+            stale.header().timestamps->value = 9;
+            y.segment_received(stale);
+            test_err_if(y.inbound_stream().buffer_size() != 100, "the stale segment's data is dropped");
+            test_err_if(deliver_last(y, x).header().ackno != stale.header().seqno, "but it is acknowledged");
+
+            stale.header().timestamps->value = 20;
+            y.segment_received(stale);
+            test_err_if(y.inbound_stream().buffer_size() != 200, "with its real stamp, the segment is accepted");
+        }
+
+        {
+            // a delayed ACK echoes the first of the segments it covers (RFC 7323 4.3), so the RTT sample
+            // includes the delay
+            TCPConfig delayed = cfg;
+            delayed.delayed_ack = true;
+            TCPConnection x{delayed}, y{delayed};
+            handshake(x, y);
+            x.tick(10);
+            x.write(string(TCPConfig::MAX_PAYLOAD_SIZE, 'a'));
+            deliver(x, y);
+            test_err_if(not y.segments_out().empty(), "the first segment's ACK waits");
+            x.tick(10);
+            x.write(string(TCPConfig::MAX_PAYLOAD_SIZE, 'b'));
+            deliver(x, y);
+            const auto ack = deliver_last(y, x);
+            test_err_if(not ack.header().timestamps.has_value() or ack.header().timestamps->echo != 10,
+                        "the ACK of both echoes the first's stamp");
+        }
+
+        {
+            // timestamps wrap too: a stamp just past 2^32 is newer than one just before
+            TCPReceiver receiver{cfg.recv_capacity};
+            TCPSegment seg;
+            seg.header().syn = true;
+            seg.header().timestamps = TCPTimestamps{0xfffffff0, 0};
+            receiver.segment_received(seg);
+            seg.header().syn = false;
+            seg.header().seqno = WrappingInt32{1};
+            seg.payload() = string("new");
+            seg.header().timestamps->value = 0x10;
+            test_err_if(receiver.stale(seg), "a wrapped stamp is newer");
+            receiver.segment_received(seg);
+            test_err_if(receiver.ts_recent() != 0x10u, "and becomes the one to echo");
+            seg.header().seqno = WrappingInt32{4};
+            seg.header().timestamps->value = 0xfffffff5;
+            test_err_if(not receiver.stale(seg), "one from before the wrap is old");
+            receiver.segment_received(seg);
+            test_err_if(receiver.stream_out().buffer_size() != 3, "and is dropped");
+        }
+
+        {
+            // without the option on both SYNs, no segment carries it and nothing is rejected
+            TCPConfig legacy = cfg;
+            legacy.timestamps = false;
+            TCPConnection x{cfg}, y{legacy};
+            x.connect();
+            deliver_last(x, y);
+            test_err_if(deliver_last(y, x).header().timestamps.has_value(), "the SYN/ACK does not offer it");
+            test_err_if(deliver_last(x, y).header().timestamps.has_value(), "so x does not send it");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
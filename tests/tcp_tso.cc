@@ -0,0 +1,137 @@
+#include "tcp_config.hh"
+#include "tcp_segment.hh"
+#include "tcp_sender.hh"
+#include "test_err_if.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        const WrappingInt32 isn{0};
+
+        {
+            // a super-segment is cut into MSS-sized pieces with replicated, adjusted headers
+            TCPSegment seg;
+            seg.header().seqno = isn + 100;
+            seg.header().ack = true;
+            seg.header().ackno = isn + 7;
+            seg.header().win = 1234;
+            seg.header().fin = true;
+            string payload(2 * MSS + 10, 'x');
+            for (size_t i = 0; i < payload.size(); ++i) {
+                payload[i] = static_cast<char>(i);
+            }
+            seg.payload() = string(payload);
+
+            const auto pieces = seg.split(MSS);
+            test_err_if(pieces.size() != 3, "2 full segments and a remainder");
+            size_t offset = 0;
+            for (size_t i = 0; i < pieces.size(); ++i) {
+                const auto &piece = pieces[i];
+                test_err_if(piece.header().seqno != isn + 100 + offset, "each piece's seqno follows the last");
+                test_err_if(not piece.header().ack or piece.header().ackno != isn + 7 or piece.header().win != 1234,
+                            "the rest of the header is replicated");
+                test_err_if(piece.header().fin != (i == 2), "only the last piece carries the FIN");
+                test_err_if(piece.payload().str() != payload.substr(offset, MSS), "each piece gets its slice");
+
+                // every piece is a valid segment on its own, checksum included
+                TCPSegment parsed;
+                test_err_if(parsed.parse(piece.serialize(0).concatenate(), 0) != ParseResult::NoError,
+                            "a piece should parse");
+                test_err_if(parsed.header().seqno != piece.header().seqno, "the parsed seqno");
+                offset += piece.payload().size();
+            }
+
+            seg.header().syn = true;
+            const auto with_syn = seg.split(MSS);
+            test_err_if(not with_syn[0].header().syn or with_syn[1].header().syn, "only the first piece has the SYN");
+            test_err_if(with_syn[1].header().seqno != isn + 101 + MSS, "the SYN takes a sequence number");
+        }
+
+        {
+            // the sender sends super-segments, and partial ACKs trim them
+            TCPConfig cfg;
+            cfg.fixed_isn = isn;
+            cfg.tso_size = 8 * MSS;
+            cfg.congestion_control = CongestionController::Algorithm::None;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.ack_received(isn + 1, 60000);
+            sender.stream_in().write(string(20 * MSS, 'x'));
+            sender.fill_window();
+            test_err_if(sender.segments_out().size() != 3, "two super-segments and the rest");
+            test_err_if(sender.segments_out().front().payload().size() != 8 * MSS, "super-segments of tso_size");
+            while (not sender.segments_out().empty()) {
+                sender.segments_out().pop();
+            }
+
+            sender.ack_received(isn + 1 + 3 * MSS, 60000);
+            test_err_if(sender.bytes_in_flight() != 17 * MSS, "a partial ACK frees the acknowledged wire segments");
+            sender.tick(TCPConfig::TIMEOUT_DFLT);
+            test_err_if(sender.segments_out().size() != 1, "a timeout retransmits the oldest super-segment");
+            const auto &retx = sender.segments_out().front();
+            test_err_if(retx.header().seqno != isn + 1 + 3 * MSS or retx.payload().size() != 5 * MSS,
+                        "only what is still unacknowledged");
+        }
+
+        {
+            // with SACK, a block covering part of a super-segment marks that part, and only the rest is resent
+            TCPConfig cfg;
+            cfg.fixed_isn = isn;
+            cfg.tso_size = 8 * MSS;
+            cfg.fast_retransmit = true;
+            cfg.congestion_control = CongestionController::Algorithm::None;
+            TCPSender sender{cfg};
+            sender.set_sack_permitted(true);
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.ack_received(isn + 1, 60000);
+            sender.stream_in().write(string(8 * MSS, 'x'));
+            sender.fill_window();
+            test_err_if(sender.segments_out().size() != 1 or sender.segments_out().front().payload().size() != 8 * MSS,
+                        "still sent as one super-segment");
+            sender.segments_out().pop();
+
+            sender.ack_received(isn + 1, 60000, 0, {{isn + 1 + MSS, isn + 1 + 8 * MSS}});
+            test_err_if(not sender.in_fast_recovery(), "the SACKed wire segments show the first one lost");
+            test_err_if(sender.segments_out().size() != 1, "one retransmission");
+            const auto &retx = sender.segments_out().front();
+            test_err_if(retx.header().seqno != isn + 1 or retx.payload().size() != MSS,
+                        "only the wire segment that was not SACKed");
+            sender.segments_out().pop();
+
+            sender.tick(TCPConfig::TIMEOUT_DFLT);
+            test_err_if(sender.segments_out().size() != 1 or sender.segments_out().front().payload().size() != MSS,
+                        "a timeout resends the oldest wire segment, not the super-segment");
+        }
+
+        {
+            // tso_size is clamped to what an adapter will cut up
+            TCPConfig cfg;
+            cfg.tso_size = 1'000'000;
+            cfg.congestion_control = CongestionController::Algorithm::None;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.ack_received(sender.next_seqno(), 65535);
+            sender.stream_in().write(string(TCPConfig::DEFAULT_CAPACITY, 'x'));
+            sender.fill_window();
+            test_err_if(sender.segments_out().front().payload().size() != TCPConfig::MAX_TSO_SIZE,
+                        "super-segments are at most MAX_TSO_SIZE");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
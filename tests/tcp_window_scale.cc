@@ -0,0 +1,95 @@
+#include "congestion_controller.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "tcp_pair_helpers.hh"
+#include "test_err_if.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t WINDOW_MAX = numeric_limits<uint16_t>::max();
+
+int main() {
+    try {
+        {
+            // the option round-trips next to SACK-permitted
+            TCPHeader header;
+            header.syn = true;
+            header.window_scale = 7;
+            header.sack_permitted = true;
+            test_err_if(header.options_length() != 8, "window scale and SACK-permitted, NOP-aligned");
+            header.doff = (TCPHeader::LENGTH + header.options_length()) / 4;
+            test_err_if(not(reparse(header) == header), "the options should round-trip");
+            header.doff = 5;
+            test_err_if(reparse(header).window_scale.has_value(), "no room, no option");
+        }
+
+        // a 4 MiB receive buffer needs a shift of 7 to be advertised in 16 bits
+        TCPConfig cfg;
+        cfg.congestion_control = CongestionController::Algorithm::None;
+        cfg.recv_capacity = cfg.send_capacity = 4 * 1024 * 1024;
+
+        {
+            TCPConnection x{cfg}, y{cfg};
+            x.connect();
+            const auto syn = deliver_last(x, y);
+            test_err_if(syn.header().window_scale != 7, "the SYN offers a shift of 7");
+            test_err_if(syn.header().win != WINDOW_MAX, "the SYN's own window is not scaled");
+            const auto syn_ack = deliver_last(y, x);
+            test_err_if(syn_ack.header().window_scale != 7, "the SYN/ACK accepts");
+            deliver_last(x, y);
+
+            // the SYN/ACK's window is not scaled, so the first flight is 64 KiB; the first ACKs open the window
+            const string data(3 * 1024 * 1024 + 100, 'x');
+            test_err_if(x.write(data) != data.size(), "the send buffer takes it all");
+            test_err_if(x.bytes_in_flight() != WINDOW_MAX, "the first flight fills the SYN/ACK's window");
+            deliver_last(x, y);
+            deliver_last(y, x);
+            test_err_if(x.bytes_in_flight() != data.size() - WINDOW_MAX, "then the rest goes out at once");
+            deliver_last(x, y);
+            test_err_if(y.inbound_stream().buffer_size() != data.size(), "and it all arrives");
+            const auto ack_win = deliver_last(y, x).header().win;
+            test_err_if(ack_win != (cfg.recv_capacity - data.size()) >> 7, "the ACK's window is scaled down");
+            test_err_if(x.bytes_in_flight() != 0, "everything is acknowledged");
+
+            // the advertised window rounds down, so the sender never overruns the receiver
+            x.write(data);
+            test_err_if(x.bytes_in_flight() != size_t{ack_win} << 7, "the sender scales the window back up");
+            deliver_last(x, y);
+            test_err_if(y.inbound_stream().buffer_size() != data.size() + (size_t{ack_win} << 7),
+                        "the receiver takes it all");
+        }
+
+        {
+            // a peer that does not offer the option turns scaling off in both directions
+            TCPConfig legacy = cfg;
+            legacy.window_scaling = false;
+            TCPConnection x{cfg}, y{legacy};
+            x.connect();
+            deliver_last(x, y);
+            test_err_if(deliver_last(y, x).header().window_scale.has_value(), "the SYN/ACK does not offer it");
+            deliver_last(x, y);
+            x.write(string(1024 * 1024, 'x'));
+            test_err_if(x.bytes_in_flight() != WINDOW_MAX, "the sender is held to 64 KiB");
+            deliver_last(x, y);
+            test_err_if(deliver_last(y, x).header().win != WINDOW_MAX, "the receiver's window is clamped, not scaled");
+
+            // nor does a SYN/ACK offer it in reply to a SYN that did not
+            TCPConnection a{legacy}, b{cfg};
+            a.connect();
+            deliver_last(a, b);
+            test_err_if(deliver_last(b, a).header().window_scale.has_value(), "no option on the SYN/ACK");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,205 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_timers.hh"
+#include "test_err_if.hh"
+#include "timing_wheel.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+//! The send times (and whether a RST) of the segments a connection whose SYN is never answered sends
+//! until it gives up, when ticked by `drive`
+template <typename Drive>
+static vector<pair<uint64_t, bool>> unanswered_syn(Drive &&drive) {
+    TCPConfig cfg;
+    cfg.rt_timeout = 10;
+    TCPConnection conn{cfg};
+    conn.connect();
+    vector<pair<uint64_t, bool>> sent;
+    uint64_t now_ms = 0;
+    const auto collect = [&] {
+        while (not conn.segments_out().empty()) {
+            sent.emplace_back(now_ms, conn.segments_out().front().header().rst);
+            conn.segments_out().pop();
+        }
+    };
+    collect();
+    drive(conn, now_ms, collect);
+    return sent;
+}
+
+int main() {
+    try {
+        {
+            // timers expire exactly on time, at every distance, however the clock is advanced
+            TimingWheel wheel;
+            mt19937 rng{1};
+            map<uint64_t, uint64_t> expected;  // key -> expiry
+            map<uint64_t, TimingWheel::TimerId> ids;
+            const vector<uint64_t> delays{1, 2, 63, 64, 65, 4095, 4096, 4097, 262144, 1u << 24, (1u << 24) + 3};
+            uint64_t key = 0;
+            for (const auto delay : delays) {
+                ids[key] = wheel.arm(delay, key);
+                expected[key++] = delay;
+            }
+            for (size_t i = 0; i < 2000; ++i) {
+                const auto delay = uniform_int_distribution<uint64_t>{1, 300000}(rng);
+                ids[key] = wheel.arm(delay, key);
+                expected[key++] = delay;
+            }
+            // cancel every third; rearm every fifth further out
+            for (uint64_t k = 0; k < key; k += 3) {
+                test_err_if(not wheel.cancel(ids[k]) or wheel.cancel(ids[k]), "cancel once");
+                expected.erase(k);
+            }
+            for (uint64_t k = 1; k < key; k += 5) {
+                ids[k] = wheel.rearm(ids[k], expected[k] + 1000, k);
+                expected[k] += 1000;
+            }
+            test_err_if(wheel.size() != expected.size(), "armed timers are counted");
+
+            size_t fired = 0;
+            uniform_int_distribution<uint64_t> step{0, 5000};
+            while (wheel.size() > 0) {
+                wheel.advance(step(rng), [&](const uint64_t k) {
+                    test_err_if(expected.count(k) != 1, "only armed timers fire, once");
+                    test_err_if(expected[k] != wheel.now_ms(), "a timer fires on time");
+                    expected.erase(k);
+                    ++fired;
+                });
+            }
+            test_err_if(not expected.empty() or fired == 0, "every timer fires");
+        }
+
+        {
+            // the visitor sees each timer at its own time, and may rearm it
+            TimingWheel wheel;
+            wheel.arm(10, 7);
+            vector<uint64_t> times;
+            wheel.advance(100, [&](const uint64_t) {
+                times.push_back(wheel.now_ms());
+                if (times.size() < 3) {
+                    wheel.arm(30, 7);
+                }
+            });
+            test_err_if((times != vector<uint64_t>{10, 40, 70}), "a periodic timer");
+            test_err_if(wheel.now_ms() != 100, "the clock ends where it was advanced to");
+        }
+
+        {
+            // a TCP timer moved later stays filed where it was, and goes off at its new deadline
+            using Kind = TCPTimers::Kind;
+            TimingWheel wheel;
+            TCPTimers timers{wheel, 5};
+            timers.arm(Kind::Retransmission, 10);
+            wheel.advance(5, [](const uint64_t) {});
+            timers.arm(Kind::Retransmission, 10);
+            test_err_if(timers.ms_until(Kind::Retransmission) != 10, "the new deadline");
+            vector<uint64_t> times;
+            wheel.advance(20, [&](const uint64_t key) {
+                test_err_if(TCPTimers::endpoint_of(key) != 5, "the endpoint's key");
+                if (timers.fired(TCPTimers::kind_of(key))) {
+                    times.push_back(wheel.now_ms());
+                }
+            });
+            test_err_if((times != vector<uint64_t>{15}), "it goes off once, at the new deadline");
+
+            // on a wheel of its own, as of the end of each advance
+            TCPTimers own;
+            vector<Kind> visited;
+            const auto visit = [&](const Kind kind) { visited.push_back(kind); };
+            own.arm(Kind::Retransmission, 10);
+            own.arm(Kind::DelayedAck, 40);
+            own.advance(5, visit);
+            own.arm(Kind::Retransmission, 10);
+            own.advance(9, visit);
+            test_err_if(not visited.empty(), "nothing is due yet");
+            own.advance(100, visit);
+            test_err_if((visited != vector<Kind>{Kind::Retransmission, Kind::DelayedAck}), "once each, in order");
+        }
+
+        {
+            // a connection ticked only when its timers are due behaves as one ticked every millisecond
+            const auto every_ms = unanswered_syn([](TCPConnection &conn, uint64_t &now_ms, auto &&collect) {
+                while (conn.active()) {
+                    conn.tick(1);
+                    ++now_ms;
+                    collect();
+                }
+            });
+            const auto on_deadlines = unanswered_syn([](TCPConnection &conn, uint64_t &now_ms, auto &&collect) {
+                TimingWheel wheel;
+                uint64_t last_tick_ms = 0;
+                auto timeout = conn.ms_until_timeout();
+                while (timeout.has_value()) {
+                    wheel.arm(timeout.value(), 0);
+                    wheel.advance(timeout.value(), [&](const uint64_t) {
+                        now_ms = wheel.now_ms();
+                        conn.tick(now_ms - last_tick_ms);
+                        last_tick_ms = now_ms;
+                        collect();
+                    });
+                    timeout = conn.ms_until_timeout();
+                }
+            });
+            test_err_if(every_ms.size() != TCPConfig::MAX_RETX_ATTEMPTS + 2 or not every_ms.back().second,
+                        "the SYN, its retransmissions, then a RST");
+            test_err_if(on_deadlines != every_ms, "the same segments at the same times");
+
+            // connections with their timers on the host's wheel are only called when those go off; moving
+            // one (as the vector grows) takes its timers along
+            TimingWheel wheel;
+            TCPConfig cfg;
+            cfg.rt_timeout = 10;
+            vector<TCPConnection> conns;
+            vector<vector<pair<uint64_t, bool>>> sent(3);
+            const auto collect = [&](const size_t i) {
+                for (auto &out = conns[i].segments_out(); not out.empty(); out.pop()) {
+                    sent[i].emplace_back(wheel.now_ms(), out.front().header().rst);
+                }
+            };
+            for (size_t i = 0; i < sent.size(); ++i) {
+                conns.emplace_back(cfg, wheel, i);
+                conns.back().connect();
+                collect(i);
+            }
+            while (wheel.size() > 0) {
+                wheel.advance(1000, [&](const uint64_t key) {
+                    conns[TCPTimers::endpoint_of(key)].timer_expired(TCPTimers::kind_of(key));
+                    collect(TCPTimers::endpoint_of(key));
+                });
+            }
+            for (const auto &segments : sent) {
+                test_err_if(segments != every_ms, "the same segments at the same times on a shared wheel");
+            }
+
+            bool threw = false;
+            try {
+                conns[0].tick(1);
+            } catch (const exception &) {
+                threw = true;
+            }
+            test_err_if(not threw, "a connection on a shared wheel is not ticked");
+
+            {
+                TCPConnection gone{cfg, wheel, 3};
+                gone.connect();
+                test_err_if(wheel.size() != 1, "the SYN is timed on the shared wheel");
+            }
+            test_err_if(wheel.size() != 0, "a destroyed connection's timers are cancelled");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}